@@ -4,7 +4,14 @@
 #include <CQBaseModelTypes.h>
 #include <QAbstractItemModel>
 #include <map>
+#include <vector>
+#include <unordered_map>
+#include <memory>
 #include <future>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 
 /*!
  * \brief Wrapper class for QAbstractItemModel with extra features
@@ -23,12 +30,23 @@
  *   . title
  *  extra row values
   *  . group
+ *
+ * Concurrency
+ *  Any number of reader threads can access the model (data, column details, row
+ *  groups) while a single writer (normally the GUI thread) edits it. Readers take a
+ *  shared lock on the model mutex and writers (setData, column/row changes) an
+ *  exclusive lock. Structural changes (reset, insert/remove rows) must not run
+ *  while reader threads are active. Lazily initialized values (column types,
+ *  details) use atomics so readers only lock when they need to calculate them.
+ *  Column and row meta data (title, min/max, group, ...) are copied out by value
+ *  with the lock held.
  */
 class CQBaseModel : public QAbstractItemModel {
   Q_OBJECT
 
   Q_PROPERTY(QString     title        READ title        WRITE setTitle       )
   Q_PROPERTY(int         maxTypeRows  READ maxTypeRows  WRITE setMaxTypeRows )
+  Q_PROPERTY(int         maxTypeTime  READ maxTypeTime  WRITE setMaxTypeTime )
   Q_PROPERTY(QModelIndex currentIndex READ currentIndex WRITE setCurrentIndex)
   Q_PROPERTY(DataType    dataType     READ dataType)
 
@@ -88,7 +106,7 @@ class CQBaseModel : public QAbstractItemModel {
  public:
   CQBaseModel(QObject *parent=nullptr);
 
-  virtual ~CQBaseModel() { }
+  virtual ~CQBaseModel();
 
   //---
 
@@ -104,6 +122,19 @@ class CQBaseModel : public QAbstractItemModel {
   int maxTypeRows() const { return maxTypeRows_; }
   void setMaxTypeRows(int i) { maxTypeRows_ = i; }
 
+  //! get/set max time (microseconds) to process to determine type
+  int maxTypeTime() const { return maxTypeTime_; }
+  void setMaxTypeTime(int t) { maxTypeTime_ = t; }
+
+  //! get/set rows sampled to determine type (provisional types refined if async types
+  //! or by explicit refineColumnType(s))
+  const CQBaseModelTypeSample &typeSample() const { return typeSample_; }
+  void setTypeSample(const CQBaseModelTypeSample &s) { typeSample_ = s; }
+
+  //! get/set refine provisional column types automatically in background threads
+  bool isAsyncTypes() const { return asyncTypes_; }
+  void setAsyncTypes(bool b) { asyncTypes_ = b; if (b) scheduleRefineColumnTypes(); }
+
   //! get/set current index
   const QModelIndex &currentIndex() const { return currentIndex_; }
   void setCurrentIndex(const QModelIndex &ind);
@@ -120,6 +151,9 @@ class CQBaseModel : public QAbstractItemModel {
   CQBaseModelType columnType(int column) const;
   bool setColumnType(int column, CQBaseModelType t);
 
+  //! get if column type is provisional (calculated from sample and could be promoted)
+  bool isColumnTypeProvisional(int column) const;
+
   //! get/set column base type (original/calculated)
   CQBaseModelType columnBaseType(int column) const;
   bool setColumnBaseType(int column, CQBaseModelType t);
@@ -148,6 +182,15 @@ class CQBaseModel : public QAbstractItemModel {
   bool isColumnKey(int column) const;
   bool setColumnKey(int column, bool b);
 
+  //! get row for key column value (-1 if not found)
+  virtual int rowForKey(int column, const QVariant &value) const;
+
+  //! get rows with key column value matching an earlier row's value
+  virtual std::vector<int> keyDuplicates(int column) const;
+
+  //! get if key column has duplicate values
+  virtual bool hasKeyDuplicates(int column) const;
+
   //! get/set column is sorted
   bool isColumnSorted(int column) const;
   bool setColumnSorted(int column, bool b);
@@ -206,6 +249,10 @@ class CQBaseModel : public QAbstractItemModel {
   //! get data (no set data as read only)
   QVariant data(const QModelIndex &index, int role) const override;
 
+  //! get raw (unconverted) values of column for n rows from row (false if not supported)
+  virtual bool getRawColumnValues(int column, int row, int n,
+                                  std::vector<QVariant> &values) const;
+
   //---
 
   virtual const RoleDatas &headerRoleDatas(Qt::Orientation orient) const;
@@ -257,12 +304,18 @@ class CQBaseModel : public QAbstractItemModel {
 
   void copyColumnHeaderRoles(QAbstractItemModel *toModel, int c1, int c2) const;
 
+ public Q_SLOTS:
+  //! refine provisional column type(s) by checking all rows
+  void refineColumnType(int column);
+  void refineColumnTypes();
+
  Q_SIGNALS:
   //! signals when data changed
   void columnTypeChanged      (int column);
   void columnBaseTypeChanged  (int column);
   void columnRangeChanged     (int column);
   void columnKeyChanged       (int column);
+  void columnKeyDuplicate     (int column, int row);
   void columnSortedChanged    (int column);
   void columnSortOrderChanged (int column);
   void columnTitleChanged     (int column);
@@ -277,6 +330,57 @@ class CQBaseModel : public QAbstractItemModel {
   using KeyValue       = std::map<QString, QVariant>;
   using MetaNameValues = std::map<QString, KeyValue>;
   using ModelType      = CQBaseModelType;
+  using Mutex          = std::shared_mutex;
+  using ReadLock       = std::shared_lock<Mutex>;
+  using WriteLock      = std::unique_lock<Mutex>;
+
+  //---
+
+  //! copyable atomic value (for values lazily set by reader threads)
+  template<typename T>
+  class AtomicValue {
+   public:
+    AtomicValue(const T &t=T()) : t_(t) { }
+
+    AtomicValue(const AtomicValue &rhs) : t_(rhs.t_.load()) { }
+
+    AtomicValue &operator=(const AtomicValue &rhs) { t_.store(rhs.t_.load()); return *this; }
+    AtomicValue &operator=(const T &t) { t_.store(t); return *this; }
+
+    operator T() const { return t_.load(); }
+
+   private:
+    std::atomic<T> t_;
+  };
+
+  //! copy on write value (copies share value until one is modified)
+  template<typename T>
+  class SharedValue {
+   public:
+    SharedValue() = default;
+
+    //! get value (for read)
+    const T &get() const {
+      static const T s_empty;
+
+      return (t_ ? *t_ : s_empty);
+    }
+
+    //! get value for modify (copied if shared)
+    T &modify() {
+      if      (! t_)
+        t_ = std::make_shared<T>();
+      else if (t_.use_count() > 1)
+        t_ = std::make_shared<T>(*t_);
+
+      return *t_;
+    }
+
+    void clear() { t_.reset(); }
+
+   private:
+    std::shared_ptr<T> t_;
+  };
 
   //---
 
@@ -286,9 +390,15 @@ class CQBaseModel : public QAbstractItemModel {
      column(column) {
     }
 
+    using AtomicType   = AtomicValue<ModelType>;
+    using AtomicBool   = AtomicValue<bool>;
+    using AtomicThread = AtomicValue<std::thread::id>;
+
     int           column          { -1 };                 //!< column
-    ModelType     type            { ModelType::NONE };    //!< auto or assigned type
-    ModelType     baseType        { ModelType::NONE };    //!< auto or assigned base type
+    AtomicType    type            { ModelType::NONE };    //!< auto or assigned type
+    AtomicType    baseType        { ModelType::NONE };    //!< auto or assigned base type
+    AtomicBool    typeProvisional { false };              //!< type from sample rows
+    AtomicThread  typeCalcThread;                         //!< thread calculating type
     QString       typeValues;                             //!< type values
     QVariant      min;                                    //!< custom min value
     QVariant      max;                                    //!< custom max value
@@ -301,10 +411,15 @@ class CQBaseModel : public QAbstractItemModel {
     QString       tip;                                    //!< tip
     ModelType     headerType      { ModelType::NONE };    //!< header type
     QString       headerTypeValues;                       //!< header type values
-    RoleRowValues roleRowValues;                          //!< row role values
+    SharedValue<RoleRowValues> roleRowValues;             //!< row role values (shared
+                                                          //!< with model copies)
   };
 
-  using ColumnDatas = std::map<int, ColumnData>;
+  using ColumnDataP  = std::unique_ptr<ColumnData>;
+  using ColumnDatas  = std::vector<ColumnDataP>;
+  using ColumnTable  = std::vector<ColumnData *>;
+  using ColumnTableP = std::unique_ptr<ColumnTable>;
+  using ColumnTables = std::vector<ColumnTableP>;
 
   //---
 
@@ -318,7 +433,8 @@ class CQBaseModel : public QAbstractItemModel {
     QVariant group;      //!< group
   };
 
-  using RowDatas = std::map<int, RowData>;
+  using RowDatas       = std::unordered_map<int, RowData>;
+  using SharedRowDatas = SharedValue<RowDatas>;
 
   //---
 
@@ -329,28 +445,71 @@ class CQBaseModel : public QAbstractItemModel {
 
   void genColumnType(const ColumnData &columnData) const;
 
+  //! is type of column being calculated by current thread
+  bool isTypeCalcThread(const ColumnData &columnData) const {
+    return (columnData.typeCalcThread == std::this_thread::get_id()); }
+
   ColumnData &getColumnData(int column);
   const ColumnData &getColumnData(int column) const;
 
+  void growColumnDatas(int column);
+  void updateColumnTable();
+  void releaseRetiredColumnDatas();
+
   RowData &getRowData(int row);
   const RowData &getRowData(int row) const;
 
  private:
   void genColumnTypeI(ColumnData &columnData);
 
+  void scheduleRefineColumnTypes();
+
+  void launchRefineColumnType(int column);
+
+  void setRefinedColumnType(int column, CQBaseModelType type);
+
+ protected:
+  void cancelRefineColumnTypes(bool restart=true);
+
+  void cancelRefineColumnType(int column);
+
  protected:
   QString     title_;                          //!< model title
-  ColumnDatas columnDatas_;                    //!< column datas
-  RowDatas    rowDatas_;                       //!< row datas
+  ColumnDatas columnDatas_;                    //!< column datas (by column)
+  SharedRowDatas rowDatas_;                    //!< row datas (sparse, shared with copies)
   int         maxTypeRows_ { -1 };             //!< max rows to determine type
+  int         maxTypeTime_ { -1 };             //!< max time to determine type
+
+  CQBaseModelTypeSample typeSample_ { CQBaseModelTypeSample::HEAD }; //!< type sample
+
+  //! background column type refine
+  struct RefineData {
+    int                                column { -1 }; //!< column
+    std::future<void>                  future;        //!< refine thread
+    std::shared_ptr<std::atomic<bool>> cancel;        //!< cancel flag
+  };
+
+  using RefineDatas = std::vector<RefineData>;
+
+  bool              asyncTypes_    { false }; //!< refine provisional types (opt-in)
+  std::atomic<bool> refinePending_ { false }; //!< type refine queued
+  RefineDatas       refineDatas_;             //!< background type refines
+  mutable std::mutex refineMutex_;            //!< background type refine mutex
   DataType    dataType_    { DATA_TYPE_NONE }; //!< input data type
 
   MetaNameValues metaNameValues_; //!< meta name values
 
   QModelIndex currentIndex_; //!< current index
 
-  mutable std::mutex mutex_;     //!< mutex
-  mutable std::mutex typeMutex_; //!< type mutex
+  // column data table (lock free lookup). Column datas are only added or replaced (and
+  // tables replaced) while locked, old tables and column datas are kept for current
+  // readers until model reset (or copy) when no readers are active
+  ColumnTables                     columnTables_;             //!< column data tables
+  std::atomic<const ColumnTable *> columnTable_ { nullptr }; //!< current column data table
+  ColumnDatas                      retiredColumnDatas_;       //!< replaced column datas
+
+  mutable Mutex      mutex_;     //!< model data mutex (shared for readers)
+  mutable std::mutex typeMutex_; //!< type calculation mutex
 
   int resetDepth_ { 0 }; //!< reset model depth
 };
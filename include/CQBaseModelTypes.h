@@ -14,6 +14,13 @@ enum class CQBaseModelDataType {
   PIVOT
 };
 
+//! column type inference sample strategies
+enum class CQBaseModelTypeSample {
+  HEAD,       //!< first rows
+  STRATIFIED, //!< random row from each of equal size row ranges
+  FULL        //!< all rows
+};
+
 //! model roles supported by CQBaseModel
 enum class CQBaseModelRole {
   Type              = Qt::UserRole + 1, //!< column value's type
@@ -2,8 +2,12 @@
 #define CQDataModel_H
 
 #include <CQBaseModel.h>
+#include <CQDataModelStore.h>
 #include <QRegExp>
+#include <QHash>
 #include <vector>
+#include <unordered_map>
+#include <atomic>
 
 class CQModelDetails;
 
@@ -11,6 +15,16 @@ class CQModelDetails;
  * \brief model derived from base model which supports a 2d array of variant values
  *
  * Can be made writable to update values.
+ *
+ * Follows the base model concurrency model: cell values and cached role values can
+ * be read from any number of threads (shared lock) while edits (setData) take an
+ * exclusive lock. Column value indices are built on first lookup under the exclusive
+ * lock and then searched under the shared lock. The filter and model details are
+ * created once (double checked with atomics). The unindexed column value cache
+ * (getColumnValues, updateColumnValues) is not thread safe and is for the GUI thread.
+ *
+ * Background readers can also take a snapshot of the data which shares the row storage
+ * (copy on write chunks) and can be read without locks while the model is edited.
  */
 class CQDataModel : public CQBaseModel {
   Q_OBJECT
@@ -20,7 +34,38 @@ class CQDataModel : public CQBaseModel {
   Q_PROPERTY(QString filename READ filename   WRITE setFilename)
 
  public:
-  using Cells = std::vector<QVariant>;
+  using Cells   = std::vector<QVariant>;
+  using Columns = std::vector<int>;
+
+  //! immutable view of model data when snapshot taken. Shares row storage with model
+  //! (rows changed later are copied by the model) so can be read from any thread.
+  class Snapshot {
+   public:
+    Snapshot() = default;
+
+    int numRows   () const { return int(data_.size()); }
+    int numColumns() const {
+      return int(columnMap_.empty() ? hheader_.size() : columnMap_.size()); }
+
+    //! data version when snapshot taken
+    size_t version() const { return data_.version(); }
+
+    //! get cell value (invalid if out of range)
+    QVariant value(int row, int column) const;
+
+    //! get horizontal header value
+    QVariant headerValue(int column) const;
+
+   private:
+    friend class CQDataModel;
+
+    Cells            hheader_;   //!< horizontal header values
+    Columns          columnMap_; //!< model column to data column
+    CQDataModelStore data_;      //!< row values
+
+    int dataColumn(int column) const {
+      return (columnMap_.empty() ? column : columnMap_[size_t(column)]); }
+  };
 
  public:
   CQDataModel(QObject *parent=nullptr);
@@ -35,6 +80,14 @@ class CQDataModel : public CQBaseModel {
 
   //---
 
+  //! get snapshot of current data (O(1), no copy of rows)
+  Snapshot snapshot() const;
+
+  //! get data version (changed on each modification)
+  size_t dataVersion() const;
+
+  //---
+
   //! resize
   virtual void resizeModel(int numCols, int numRows);
 
@@ -81,6 +134,9 @@ class CQDataModel : public CQBaseModel {
 
   bool setData(const QModelIndex &index, const QVariant &value, int role=Qt::DisplayRole) override;
 
+  bool getRawColumnValues(int column, int row, int n,
+                          std::vector<QVariant> &values) const override;
+
   QModelIndex index(int row, int column, const QModelIndex &parent=QModelIndex()) const override;
 
   QModelIndex parent(const QModelIndex &index) const override;
@@ -102,15 +158,43 @@ class CQDataModel : public CQBaseModel {
 
   //---
 
+  //! get/set column has hashed value index (value to rows) for fast value lookup
+  bool isColumnIndexed(int column) const;
+  void setColumnIndexed(int column, bool b);
+
+  //! find first row with column value (QVariant == match). An indexed column probes the
+  //! string, numeric and bool forms of the value so other value types are only found
+  //! in cells of the same type
   int findColumnValue(int column, const QVariant &var) const;
 
+  //! find all rows with column value
+  std::vector<int> findColumnValues(int column, const QVariant &var) const;
+
   void getColumnValues(int column, QVariantList &vars) const;
 
+  //---
+
+  //! key column lookup (uses maintained unique hash index)
+  int rowForKey(int column, const QVariant &value) const override;
+
+  std::vector<int> keyDuplicates(int column) const override;
+
+  bool hasKeyDuplicates(int column) const override;
+
  protected slots:
   void resetColumnCache(int column);
 
+  void updateKeyColumn(int column);
+
+  //! invalidate cached horizontal header values
+  void resetHeaderCache(int column);
+  void resetHeaderCache();
+
+  void headerCacheChanged(Qt::Orientation orient, int first, int last);
+  void dataCacheChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
  protected:
-  using Data  = std::vector<Cells>;
+  using Data  = CQDataModelStore;
 
  protected:
   void init(int numCols=0, int numRows=0);
@@ -129,14 +213,39 @@ class CQDataModel : public CQBaseModel {
 
   //---
 
+  //! select/reorder columns by name (or number). Data is kept and columns mapped
   void applyFilterColumns(const QStringList &columns);
 
+  //! get/set column projection (data column for each model column, empty for all)
+  const Columns &columnMap() const { return columnMap_; }
+  void setColumnMap(const Columns &columns);
+
+  //! get data (storage) column for model column
+  int dataColumn(int column) const {
+    return (columnMap_.empty() ? column : columnMap_[size_t(column)]); }
+
   //---
 
   void clearCachedColumn();
 
   void updateColumnValues(int column) const;
 
+  //---
+
+  struct ColumnIndex;
+
+  ColumnIndex *getColumnIndex(int column) const;
+
+  void updateColumnIndex(int row, int column, const QVariant &oldValue,
+                         const QVariant &newValue);
+
+  void addColumnIndexRows(int row, int n);
+
+  void invalidateColumnIndices();
+
+  static QString columnIndexKey(const QVariant &var);
+  static QStringList columnIndexKeys(const QVariant &var);
+
  protected:
   struct FilterData {
     int     column { -1 };
@@ -146,22 +255,58 @@ class CQDataModel : public CQBaseModel {
 
   using FilterDatas = std::vector<FilterData>;
 
+  void buildFilterDatas(FilterDatas &filterDatas) const;
+
+  struct IndexKeyHash {
+    size_t operator()(const QString &s) const { return qHash(s); }
+  };
+
+  using IndexRows      = std::vector<int>;
+  using IndexValueRows = std::unordered_map<QString, IndexRows, IndexKeyHash>;
+
+  //! hashed column value index (value key to sorted rows)
+  struct ColumnIndex {
+    bool           valid         { false }; //!< is index built
+    bool           indexed       { false }; //!< index explicitly enabled
+    bool           key           { false }; //!< index for key column
+    IndexValueRows valueRows;               //!< rows for value
+    int            numDuplicates { 0 };     //!< number of values with multiple rows
+  };
+
+  using ColumnIndices = std::map<int, ColumnIndex>;
+
+  //! cached horizontal header role values (by column)
+  using HeaderRoleValues = std::map<int, QVariant>;
+  using HeaderCache      = std::vector<HeaderRoleValues>;
+
+  bool getHeaderCache(int section, int role, QVariant &value) const;
+  void setHeaderCache(int section, int role, const QVariant &value) const;
+
+  QVariant calcHeaderData(int section, int role) const;
+
+  const ColumnIndex *readColumnIndex(int column, ReadLock &lock) const;
+
   bool readOnly_ { false }; //!< is read only
 
   QString filename_; //!< input filename
 
-  Cells hheader_; //!< horizontal header values
-  Cells vheader_; //!< vertical header values
-  Data  data_;    //!< row values
+  Cells   hheader_;   //!< horizontal header values (by data column)
+  Cells   vheader_;   //!< vertical header values
+  Data    data_;      //!< row values
+  Columns columnMap_; //!< model column to data column (empty if not projected)
+
+  QString           filter_;                 //!< filter text
+  std::atomic<bool> filterInited_ { false }; //!< filter initialized
+  FilterDatas       filterDatas_;            //!< filter datas
+
+  std::atomic<CQModelDetails*> details_ { nullptr }; //!< model details (created on demand)
 
-  QString     filter_;                 //!< filter text
-  bool        filterInited_ { false }; //!< filter initialized
-  FilterDatas filterDatas_;            //!< filter datas
+  mutable int          cachedColumn_ { -1 }; //!< cached column
+  mutable QVariantList cachedColumnVars_;    //!< cached column values
 
-  CQModelDetails* details_ { nullptr }; //!< model details
+  mutable ColumnIndices columnIndices_; //!< hashed column value indices
 
-  mutable int          cachedColumn_ { -1 };
-  mutable QVariantList cachedColumnVars_;
+  mutable HeaderCache headerCache_; //!< cached horizontal header values
 };
 
 #endif
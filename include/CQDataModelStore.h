@@ -0,0 +1,89 @@
+#ifndef CQDataModelStore_H
+#define CQDataModelStore_H
+
+#include <QVariant>
+#include <vector>
+#include <memory>
+
+/*!
+ * \brief Row storage for data model with copy on write chunks
+ *
+ * Rows are stored in chunks (of at most chunkRows rows) referenced from a shared
+ * chunk table. Copying the store is O(1) (the table is shared) and modifying a row
+ * only clones the chunk table (if shared) and the chunk containing the row (if shared),
+ * so copies (snapshots) are unaffected by later edits.
+ *
+ * Rows are appended in full chunks. Erase only changes the chunk containing the row
+ * so chunks can become uneven, the chunk of a row is then found from the first row
+ * of each chunk (binary search).
+ *
+ * The version is incremented on every change so copies can be compared with
+ * the current data.
+ */
+class CQDataModelStore {
+ public:
+  using Cells = std::vector<QVariant>;
+
+  static constexpr size_t chunkRows = 1024; //!< max rows per chunk
+
+ public:
+  CQDataModelStore() = default;
+
+  //! number of rows
+  size_t size() const { return numRows_; }
+  bool empty() const { return numRows_ == 0; }
+
+  //! data version (changed on every modification)
+  size_t version() const { return version_; }
+
+  //! get row (read only)
+  const Cells &operator[](size_t r) const;
+
+  //! get row for modification (detaches shared chunk)
+  Cells &modifyRow(size_t r);
+
+  //! add row at end
+  void push_back(const Cells &cells);
+
+  //! remove row
+  void erase(size_t r);
+
+  //! set number of rows (new rows are empty)
+  void resize(size_t n);
+
+  //! remove all rows
+  void clear();
+
+  //! is chunk storage shared with another copy
+  bool isShared() const;
+
+ private:
+  using Chunk  = std::vector<Cells>;
+  using ChunkP = std::shared_ptr<Chunk>;
+  using Chunks = std::vector<ChunkP>;
+  using Starts = std::vector<size_t>;
+
+  //! chunk table
+  struct Table {
+    Chunks chunks;         //!< row chunks
+    Starts starts;         //!< first row of each chunk
+    bool   even { true };  //!< all chunks (except last) have chunkRows rows
+  };
+
+  using TableP = std::shared_ptr<Table>;
+
+  size_t locate(size_t r, size_t &ic) const;
+
+  Table &detachTable();
+
+  Chunk &detachChunk(size_t i);
+
+  void addChunk(size_t nr);
+
+ private:
+  TableP table_;          //!< shared chunk table
+  size_t  numRows_ { 0 }; //!< number of rows
+  size_t  version_ { 0 }; //!< data version
+};
+
+#endif
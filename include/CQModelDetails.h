@@ -3,6 +3,7 @@
 
 #include <CQBaseModelTypes.h>
 #include <future>
+#include <atomic>
 
 class CQModelColumnDetails;
 class CQValueSet;
@@ -20,7 +21,9 @@ class CQModelDetails : public QObject {
   Q_PROPERTY(int hierarchical READ isHierarchical)
 
  public:
-  using Columns = std::vector<int>;
+  using Columns       = std::vector<int>;
+  using DuplicateRows = std::vector<int>;
+  using DuplicateSets = std::vector<DuplicateRows>;
 
  public:
   CQModelDetails(QAbstractItemModel *model);
@@ -46,16 +49,36 @@ class CQModelDetails : public QObject {
 
   void reset();
 
+  //! get rows which duplicate an earlier row (all columns or single column)
   std::vector<int> duplicates() const;
   std::vector<int> duplicates(int column) const;
 
+  //! get sets of rows with equal values (all columns or single column)
+  DuplicateSets duplicateSets() const;
+  DuplicateSets duplicateSets(int column) const;
+
+  //! get/set group duplicates by sorting row hashes instead of hash table (less memory)
+  bool isLowMemory() const { return lowMemory_; }
+  void setLowMemory(bool b) { lowMemory_ = b; }
+
  signals:
   void detailsReset();
 
  protected:
   void resetValues();
 
-  std::vector<int> columnDuplicates(int column, bool all) const;
+  using RowHashes = std::vector<size_t>;
+
+  DuplicateSets columnDuplicateSets(int column, bool all) const;
+
+  void calcRowHashes(int column, bool all, RowHashes &hashes) const;
+
+  size_t rowHash(int row, int column, bool all) const;
+
+  bool rowValuesEqual(int row1, int row2, int column, bool all) const;
+
+  void addCollisionSets(const DuplicateRows &rows, int column, bool all,
+                        DuplicateSets &sets) const;
 
   void updateSimple();
   void updateFull();
@@ -79,11 +102,13 @@ class CQModelDetails : public QObject {
   QAbstractItemModel* model_ { nullptr }; //!< model
 
   // cached data
-  Initialized   initialized_  { Initialized::NONE }; //!< is initialized
-  int           numColumns_   { 0 };                 //!< model number of columns
-  int           numRows_      { 0 };                 //!< model number of rows
-  bool          hierarchical_ { false };             //!< model is hierarchical
-  ColumnDetails columnDetails_;                      //!< model column details
+  std::atomic<Initialized> initialized_  { Initialized::NONE }; //!< is initialized
+  int                      numColumns_   { 0 };                 //!< model number of columns
+  int                      numRows_      { 0 };                 //!< model number of rows
+  bool                     hierarchical_ { false };             //!< model is hierarchical
+  ColumnDetails            columnDetails_;                      //!< model column details
+  bool                     lowMemory_    { false };             //!< sort based duplicate
+                                                                //!< detection
 
   // mutex
   mutable std::mutex mutex_; //!< mutex
@@ -150,9 +175,10 @@ class CQModelColumnDetails {
 
   int numNull() const;
 
-  int numValues() const { return int(valueInds_.size()); }
+  // number of unique values and index of value (same as numUnique and uniqueId)
+  int numValues() const { return numUnique(); }
 
-  int valueInd(const QVariant &value) const;
+  int valueInd(const QVariant &value) const { return uniqueId(value); }
 
   QVariant medianValue     (bool useNaN=true) const;
   QVariant lowerMedianValue(bool useNaN=true) const;
@@ -180,31 +206,26 @@ class CQModelColumnDetails {
   void addReal  (double r);
   void addString(const QString &s);
 
-  void addValue(const QVariant &value);
-
  protected:
   CQModelColumnDetails(const CQModelColumnDetails &) = delete;
   CQModelColumnDetails &operator=(const CQModelColumnDetails &) = delete;
 
  protected:
-  using VariantInds = std::map<QVariant, int>;
-
-  CQModelDetails* details_ { nullptr };
-  int             column_  { -1 };
+  CQModelDetails*   details_ { nullptr };
+  int               column_  { -1 };
 
   // cached type data
-  bool            typeInitialized_ { false };                 //!< is type data set
-  CQBaseModelType type_            { CQBaseModelType::NONE }; //!< column data type
+  std::atomic<bool> typeInitialized_ { false };                 //!< is type data set
+  CQBaseModelType   type_            { CQBaseModelType::NONE }; //!< column data type
 
   // cached data
-  bool            initialized_     { false };   //!< is data set
-  QVariant        minValue_;                    //!< min value (as variant)
-  QVariant        maxValue_;                    //!< max value (as variant)
-  int             numRows_         { 0 };       //!< number of rows
-  bool            monotonic_       { true };    //!< values are monotonic
-  bool            increasing_      { true };    //!< values are increasing
-  CQValueSet*     valueSet_        { nullptr }; //!< values
-  VariantInds     valueInds_;                   //!< unique values
+  std::atomic<bool> initialized_     { false };   //!< is data set
+  QVariant          minValue_;                    //!< min value (as variant)
+  QVariant          maxValue_;                    //!< max value (as variant)
+  int               numRows_         { 0 };       //!< number of rows
+  bool              monotonic_       { true };    //!< values are monotonic
+  bool              increasing_      { true };    //!< values are increasing
+  CQValueSet*       valueSet_        { nullptr }; //!< values (typed unique value index)
 
   // mutex
   mutable std::mutex mutex_; //!< mutex
@@ -0,0 +1,140 @@
+#ifndef CQModelGroupBy_H
+#define CQModelGroupBy_H
+
+#include <QVariant>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include <unordered_map>
+
+class CQDataModel;
+
+class QAbstractItemModel;
+
+/*!
+ * \brief Group By aggregation of model rows
+ *
+ * Groups rows with equal values in the key columns and calculates the aggregate
+ * values (count, sum, min, max, mean, median) of the other columns for each group.
+ * The results are returned as a new data model with a row per group (in order of
+ * first row of group) with the key column values followed by the aggregate values.
+ *
+ * Rows are grouped into per-thread partial hash tables which are merged at the end.
+ */
+class CQModelGroupBy {
+ public:
+  enum class AggregateType {
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    MEAN,
+    MEDIAN
+  };
+
+  //! aggregate column spec (count of rows if column is -1)
+  struct Aggregate {
+    int           column { -1 };
+    AggregateType type   { AggregateType::COUNT };
+    QString       name;
+
+    Aggregate() = default;
+
+    Aggregate(int column, AggregateType type, const QString &name="") :
+     column(column), type(type), name(name) {
+    }
+  };
+
+  using Columns    = std::vector<int>;
+  using Aggregates = std::vector<Aggregate>;
+
+  //! numeric values accumulator
+  struct AggregateData {
+    int                 count  { 0 };   //!< number of rows
+    int                 nvalue { 0 };   //!< number of numeric values
+    double              sum    { 0.0 }; //!< sum of values
+    double              min    { 0.0 }; //!< min value
+    double              max    { 0.0 }; //!< max value
+    std::vector<double> values;         //!< values (for median)
+
+    void addValue(double r, bool keepValues);
+
+    void merge(const AggregateData &data);
+
+    QVariant value(AggregateType type);
+  };
+
+ public:
+  CQModelGroupBy(QAbstractItemModel *model);
+
+  QAbstractItemModel *model() const { return model_; }
+
+  //! get/set key columns
+  const Columns &keyColumns() const { return keyColumns_; }
+  void setKeyColumns(const Columns &columns) { keyColumns_ = columns; }
+
+  void addKeyColumn(int column) { keyColumns_.push_back(column); }
+
+  //! get/set aggregates
+  const Aggregates &aggregates() const { return aggregates_; }
+  void setAggregates(const Aggregates &aggregates) { aggregates_ = aggregates; }
+
+  void addAggregate(int column, AggregateType type, const QString &name="") {
+    aggregates_.push_back(Aggregate(column, type, name));
+  }
+
+  //! get/set max number of threads (0 is hardware concurrency)
+  int numThreads() const { return numThreads_; }
+  void setNumThreads(int n) { numThreads_ = n; }
+
+  //! calculate groups and return new model (owned by caller)
+  CQDataModel *exec() const;
+
+  //---
+
+  static QString aggregateTypeName(AggregateType type);
+
+  static bool nameToAggregateType(const QString &name, AggregateType &type);
+
+  //! default aggregate column header name
+  QString aggregateName(const Aggregate &aggregate) const;
+
+ protected:
+  //! group key (variant key of each key column value)
+  using GroupKey = QStringList;
+
+  struct KeyHash {
+    size_t operator()(const GroupKey &key) const {
+      size_t hash = 0;
+
+      for (const auto &s : key)
+        hash ^= size_t(qHash(s)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+      return hash;
+    }
+  };
+
+  using AggregateDatas = std::vector<AggregateData>;
+
+  //! group data
+  struct GroupData {
+    int            row { -1 };     //!< first row
+    QVariantList   keyValues;      //!< key column values
+    AggregateDatas aggregateDatas; //!< aggregate values
+  };
+
+  using Groups = std::unordered_map<GroupKey, GroupData, KeyHash>;
+
+  void groupRows(int r1, int r2, Groups &groups) const;
+
+  void mergeGroups(Groups &groups, Groups &groups1) const;
+
+ private:
+  QAbstractItemModel* model_      { nullptr }; //!< source model
+  Columns             keyColumns_;             //!< key columns
+  Aggregates          aggregates_;             //!< aggregates
+  int                 numThreads_ { 0 };       //!< max number of threads
+};
+
+#endif
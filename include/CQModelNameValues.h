@@ -3,9 +3,16 @@
 
 #include <QVariant>
 #include <QFont>
+#include <map>
+#include <memory>
+#include <mutex>
 
 /*!
  * \brief Name Values class
+ *
+ * Parsed name values are cached by source string and shared (copy on write) by all
+ * instances created from the same string. Typed values (integer, real, color, font,
+ * align) are converted once per shared parse.
  */
 class CQModelNameValues {
  public:
@@ -18,12 +25,12 @@ class CQModelNameValues {
 
   virtual ~CQModelNameValues();
 
-  const NameValues &nameValues() const { return nameValues_; }
-  void setNameValues(const NameValues &v) { nameValues_ = v; }
+  const NameValues &nameValues() const { return parsed_->nameValues; }
+  void setNameValues(const NameValues &v) { modifyNameValues() = v; }
 
-  bool empty() const { return nameValues_.empty(); }
+  bool empty() const { return nameValues().empty(); }
 
-  QString toString() const { return toString(nameValues_); }
+  QString toString() const { return toString(nameValues()); }
 
   static QString toString(const NameValues &nameValues);
 
@@ -70,11 +77,29 @@ class CQModelNameValues {
     return true;
   }
 
+ protected:
+  //! get/set converted value of type for name (cached for shared parse)
+  bool typedValue(const QString &name, int type, QVariant &value) const;
+  void setTypedValue(const QString &name, int type, const QVariant &value) const;
+
  private:
-  static QStringList splitNameValues(const QString &str);
+  //! parsed name values with typed value cache
+  struct Parsed {
+    using TypedValues = std::map<std::pair<QString, int>, QVariant>;
+
+    NameValues          nameValues;  //!< name values
+    mutable std::mutex  mutex;       //!< typed values mutex
+    mutable TypedValues typedValues; //!< converted values by name and type
+  };
+
+  using ParsedP = std::shared_ptr<Parsed>;
+
+  static ParsedP parseCached(const QString &str);
+
+  NameValues &modifyNameValues();
 
  private:
-  NameValues nameValues_;
+  ParsedP parsed_; //!< parsed (shared) name values
 };
 
 #endif
@@ -3,6 +3,7 @@
 
 #include <CQBaseModelTypes.h>
 #include <QAbstractItemModel>
+#include <atomic>
 
 class QColor;
 
@@ -51,6 +52,14 @@ long modelConvInteger(const QAbstractItemModel *model, const QModelIndex &ind, b
 //! get model integer value
 long modelInteger(const QAbstractItemModel *model, const QModelIndex &ind, bool &ok);
 
+//! is variant value convertable to integer (same as modelConvInteger)
+bool isIntegerVariant(const QVariant &var);
+
+//! hash/compare key for variant value. Values have the same key if they are equal:
+//! numbers (integer, real) of the same value share a key, other types are keyed
+//! on their type and string value (or streamed data if not string convertable)
+QString variantKey(const QVariant &var);
+
 //! get model string value
 QString modelString(const QAbstractItemModel *model, const QModelIndex &ind, bool &ok);
 
@@ -62,6 +71,22 @@ bool columnValueType(const QAbstractItemModel *model, int c, CQBaseModelType &ty
 //! calculate column value type (can be limited to maximum number of rows)
 CQBaseModelType calcColumnType(const QAbstractItemModel *model, int icolumn, int maxRows=-1);
 
+//! column type sample strategy and cost budget
+struct ColumnTypeSample {
+  CQBaseModelTypeSample type    { CQBaseModelTypeSample::HEAD }; //!< sample strategy
+  int                   maxRows { -1 };                          //!< max rows (<= 0 all)
+  long                  maxTime { -1 };                          //!< max time (microseconds)
+  int                   role    { -1 };                          //!< value role (-1 edit
+                                                                 //!< then display)
+  const std::atomic<bool>* cancel { nullptr };                   //!< cancel flag
+  bool                  serial  { false };                       //!< scan on calling thread
+};
+
+//! calculate column value type from sampled rows. complete is set to false if the type
+//! could still be promoted (integer -> real -> string) by values of rows not tested
+CQBaseModelType calcColumnType(const QAbstractItemModel *model, int icolumn,
+                               const ColumnTypeSample &sample, bool *complete=nullptr);
+
 //---
 
 //! get base model (no proxy model)
@@ -4,6 +4,8 @@
 #include <QAbstractItemModel>
 #include <QModelIndex>
 #include <future>
+#include <vector>
+#include <atomic>
 
 class QAbstractItemModel;
 
@@ -22,8 +24,8 @@ class CQModelVisitor {
 
   struct VisitData {
     QModelIndex parent;
-    int         row  { -1 };
-    int         vrow { -1 };
+    int         row  { -1 }; //!< model row
+    int         vrow { -1 }; //!< visited row (count of earlier non-skipped rows)
 
     VisitData() = default;
 
@@ -86,11 +88,23 @@ class CQModelVisitor {
 
   //virtual State postVisit(const QAbstractItemModel *, const VisitData &) { return State::OK; }
 
+  //---
+
+  // parallel visit support (see CQModelVisit::execParallel)
+
+  //! create copy of visitor (with initial state) for worker (nullptr if not supported)
+  virtual CQModelVisitor *clone() const { return nullptr; }
+
+  //! merge results of worker visitor (created by clone) into this visitor
+  virtual void merge(const CQModelVisitor &) { }
+
  public:
   // only called by CQModelVisit
   void init(const QAbstractItemModel *model);
   void term();
 
+  void setRow(int row) { row_ = row; }
+
  protected:
   const QAbstractItemModel* model_            { nullptr }; //!< model to visit
   int                       numCols_          { 0 };       //!< number of columns
@@ -101,12 +115,99 @@ class CQModelVisitor {
   int                       numProcessedRows_ { 0 };       //!< total number of rows processed
   int                       maxRows_          { -1 };      //!< maximum number of rows to process
   bool                      hierarchical_     { false };   //!< is hierarchical
-  bool                      hierSet_          { false };   //!< is hierarchical set
+  std::atomic<bool>         hierSet_          { false };   //!< is hierarchical set
   mutable std::mutex        mutex_;                        //!< mutex
 };
 
 //---
 
+/*!
+ * \brief Block visitor class for model data
+ *
+ * Visits rows of a flat model in blocks (default 4096 rows) with the values of the
+ * requested columns extracted into typed arrays so per row virtual calls and model
+ * index creation are avoided.
+ */
+class CQModelBlockVisitor {
+ public:
+  using State = CQModelVisitor::State;
+
+  //! column value type
+  enum class ValueType {
+    VARIANT,
+    REAL,
+    INTEGER,
+    STRING
+  };
+
+  //! requested column
+  struct BlockColumn {
+    int       column { -1 };
+    ValueType type   { ValueType::VARIANT };
+
+    BlockColumn() = default;
+
+    BlockColumn(int column, ValueType type) :
+     column(column), type(type) {
+    }
+  };
+
+  using BlockColumns = std::vector<BlockColumn>;
+
+  //! column values for rows of block (only array for column type is set)
+  struct ColumnValues {
+    int                        column { -1 };
+    ValueType                  type   { ValueType::VARIANT };
+    std::vector<unsigned char> valid;    //!< is value valid (and converts to type)
+    std::vector<double>        reals;    //!< real values
+    std::vector<long>          integers; //!< integer values
+    std::vector<QString>       strings;  //!< string values
+    std::vector<QVariant>      variants; //!< variant values
+  };
+
+  //! block of rows
+  struct Block {
+    int                       row     { 0 }; //!< first row
+    int                       numRows { 0 }; //!< number of rows
+    std::vector<ColumnValues> columns;       //!< requested column values
+  };
+
+ public:
+  CQModelBlockVisitor() { }
+
+  virtual ~CQModelBlockVisitor() { }
+
+  //! get/set requested columns
+  const BlockColumns &blockColumns() const { return blockColumns_; }
+  void setBlockColumns(const BlockColumns &columns) { blockColumns_ = columns; }
+
+  void addColumn(int column, ValueType type) {
+    blockColumns_.push_back(BlockColumn(column, type)); }
+
+  //! get/set number of rows per block
+  int blockSize() const { return blockSize_; }
+  void setBlockSize(int n) { blockSize_ = std::max(n, 1); }
+
+  //! get/set use raw model values (if supported by model) instead of edit/display role
+  bool isRawValues() const { return rawValues_; }
+  void setRawValues(bool b) { rawValues_ = b; }
+
+  //---
+
+  virtual void initVisit(const QAbstractItemModel *) { }
+
+  virtual State visitBlock(const QAbstractItemModel *model, const Block &block) = 0;
+
+  virtual void termVisit() { }
+
+ protected:
+  BlockColumns blockColumns_;            //!< requested columns
+  int          blockSize_    { 4096 };   //!< rows per block
+  bool         rawValues_    { true };   //!< use raw model values
+};
+
+//---
+
 namespace CQModelVisit {
 
 bool exec(const QAbstractItemModel *model, CQModelVisitor &visitor);
@@ -120,6 +221,18 @@ CQModelVisitor::State execIndex(const QAbstractItemModel *model, const QModelInd
 CQModelVisitor::State execRow(const QAbstractItemModel *model, const QModelIndex &parent,
                               int r, CQModelVisitor &visitor);
 
+// visit rows of flat model in parallel using a cloned visitor for each row range.
+// Results are merged into visitor in row order. Terminate at a row stops the visit of
+// later rows and only results of rows before it (and the terminate row) are merged.
+// Each worker counts visited rows from the start row of its chunk so with SKIP the
+// visit data vrow is relative to the chunk (not the count of all earlier visited rows).
+// Falls back to sequential exec if model is hierarchical, visitor has a row limit or
+// does not support clone. Model data must be safe to read from multiple threads.
+bool execParallel(const QAbstractItemModel *model, CQModelVisitor &visitor, int numThreads=0);
+
+// visit rows of flat model in blocks (returns false if model is hierarchical)
+bool execBlocks(const QAbstractItemModel *model, CQModelBlockVisitor &visitor);
+
 }
 
 #endif
@@ -0,0 +1,122 @@
+#ifndef CQPivotModel_H
+#define CQPivotModel_H
+
+#include <CQDataModel.h>
+#include <CQModelGroupBy.h>
+#include <set>
+
+/*!
+ * \brief summary (pivot) model of source model rows grouped by key columns
+ *
+ * Has a row per group with the key column values followed by the aggregate values.
+ * The contribution of each source row is cached so source data changes, inserted
+ * and removed rows only update the aggregate cells of the affected groups.
+ */
+class CQPivotModel : public CQDataModel {
+  Q_OBJECT
+
+ public:
+  using AggregateType = CQModelGroupBy::AggregateType;
+  using Aggregate     = CQModelGroupBy::Aggregate;
+  using Columns       = CQModelGroupBy::Columns;
+  using Aggregates    = CQModelGroupBy::Aggregates;
+
+ public:
+  CQPivotModel(QAbstractItemModel *sourceModel, const Columns &keyColumns,
+               const Aggregates &aggregates);
+
+ ~CQPivotModel();
+
+  QAbstractItemModel *sourceModel() const { return sourceModel_; }
+
+  const Columns &keyColumns() const { return keyColumns_; }
+
+  const Aggregates &aggregates() const { return aggregates_; }
+
+  //! rebuild all groups from source model
+  void rebuild();
+
+ private slots:
+  void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+  void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+  void sourceRowsRemoved (const QModelIndex &parent, int first, int last);
+
+  void sourceReset();
+
+ private:
+  //! source row aggregate column value
+  struct SourceRowValue {
+    bool   valid { false };
+    double value { 0.0 };
+  };
+
+  using SourceRowValues = std::vector<SourceRowValue>;
+
+  //! cached source row contribution
+  struct SourceRowData {
+    QString         key;       //!< group key
+    QVariantList    keyValues; //!< key column values
+    SourceRowValues values;    //!< aggregate column values
+  };
+
+  using SourceRowDatas = std::vector<SourceRowData>;
+
+  //! aggregate values of group (supports removal of values)
+  //!
+  //! kept values are split into lower and upper halves (lower has the extra value
+  //! for an odd count) so the median is at the boundary of the two sets
+  struct AggregateValues {
+    int                   count  { 0 };   //!< number of rows
+    int                   nvalue { 0 };   //!< number of numeric values
+    double                sum    { 0.0 }; //!< sum of values
+    std::multiset<double> lower;          //!< lower half of sorted values
+    std::multiset<double> upper;          //!< upper half of sorted values
+
+    void add   (const SourceRowValue &value, bool keepValues);
+    void remove(const SourceRowValue &value, bool keepValues);
+
+    void balance();
+
+    QVariant value(AggregateType type) const;
+  };
+
+  using AggregateValuesList = std::vector<AggregateValues>;
+
+  //! group data
+  struct GroupData {
+    QString             key;             //!< group key
+    int                 numRows { 0 };   //!< number of source rows
+    AggregateValuesList aggregateValues; //!< aggregate values
+  };
+
+  using GroupDatas = std::vector<GroupData>;
+  using GroupRows  = std::unordered_map<QString, int, IndexKeyHash>;
+  using Rows       = std::set<int>;
+
+ private:
+  void initHeader();
+
+  void calcRowData(int row, SourceRowData &rowData) const;
+
+  void addRowData   (const SourceRowData &rowData, Rows &changedRows, bool notify);
+  void removeRowData(const SourceRowData &rowData, Rows &changedRows);
+
+  void removeEmptyGroups(Rows &changedRows);
+
+  void updateGroupRow(int row);
+
+  void emitRowsChanged(const Rows &rows);
+
+  bool isKeepValues(const Aggregate &aggregate) const;
+
+ private:
+  QAbstractItemModel* sourceModel_ { nullptr }; //!< source model
+  Columns             keyColumns_;              //!< key columns
+  Aggregates          aggregates_;              //!< aggregates
+  SourceRowDatas      sourceRowDatas_;          //!< cached source row contributions
+  GroupDatas          groupDatas_;              //!< group per model row
+  GroupRows           groupRows_;               //!< model row for group key
+};
+
+#endif
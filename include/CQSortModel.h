@@ -2,9 +2,23 @@
 #define CQSortModel_H
 
 #include <QSortFilterProxyModel>
+#include <QRegExp>
+#include <vector>
 
 /*!
  * \brief base class for sort model
+ *
+ * Filter is a comma separated list of clauses of the form <name>:<pattern> or <pattern>
+ * (matches filter key column). A filter with no <name>: prefix is a single pattern
+ * (commas are literal) otherwise a literal comma is escaped as '\,'.
+ *
+ * Each clause keeps a bitmap of the source rows it accepts so extending a clause pattern
+ * only re-tests the rows it previously accepted and removing a clause only recombines
+ * the remaining bitmaps.
+ *
+ * Clauses without a column use the filter key column (-1 matches any column) and are
+ * rebuilt when the filter key column, role or case sensitivity change. Rows must also
+ * pass the inherited QSortFilterProxyModel filter (setFilterRegExp, ...).
  */
 class CQSortModel : public QSortFilterProxyModel {
   Q_OBJECT
@@ -17,8 +31,61 @@ class CQSortModel : public QSortFilterProxyModel {
   const QString &filter() const { return filter_; }
   void setFilter(const QString &filter);
 
+  void setSourceModel(QAbstractItemModel *model) override;
+
+ protected:
+  bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+ private slots:
+  void resetFilterRows();
+
+  void insertFilterRows(const QModelIndex &parent, int first, int last);
+  void removeFilterRows(const QModelIndex &parent, int first, int last);
+
+  void updateFilterRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+ private:
+  using RowBits = std::vector<bool>;
+
+  //! filter clause
+  struct FilterClause {
+    int     column { -1 }; //!< source column
+    QString pattern;       //!< wildcard pattern
+    QRegExp regexp;        //!< pattern regexp
+    RowBits rowBits;       //!< accepted row bitmap
+  };
+
+  using FilterClauses = std::vector<FilterClause>;
+
+  QStringList splitClauses(const QString &filter) const;
+
+  void parseClauses(const QString &filter, FilterClauses &clauses);
+
+  bool parseClause(const QString &str, FilterClause &clause) const;
+
+  bool isRefinedPattern(const QString &oldPattern, const QString &newPattern) const;
+
+  void calcClauseRows(FilterClause &clause, const FilterClause *oldClause) const;
+
+  bool clauseAcceptsRow(const FilterClause &clause, int row, const QModelIndex &parent) const;
+
+  bool isFilterStateValid() const;
+
+  void updateFilterState();
+
+  void initFilterRows();
+
+  void updateAcceptedRows();
+
  private:
-  QString filter_; //!< filter
+  QString             filter_;                            //!< filter
+  FilterClauses       clauses_;                           //!< filter clauses
+  int                 clauseColumn_ { -1 };               //!< key column of clauses
+  int                 clauseRole_   { -1 };               //!< filter role of clauses
+  Qt::CaseSensitivity clauseCase_   { Qt::CaseSensitive }; //!< case sensitivity of clauses
+  RowBits             acceptedRows_;                      //!< combined accepted row bitmap
+  bool                rowsValid_    { false };            //!< accepted rows valid
+  QAbstractItemModel* filterModel_  { nullptr };          //!< model connected for updates
 };
 
 #endif
@@ -0,0 +1,102 @@
+#ifndef CQValueIndex_H
+#define CQValueIndex_H
+
+#include <vector>
+#include <map>
+#include <functional>
+
+/*!
+ * \brief typed index of unique values
+ *
+ * Each unique value is given an id and a count. Ids are assigned in order of first
+ * addition (not value order) so id order is the order values were first added.
+ * Values are looked up by value (sorted map) and by id (dense vector).
+ */
+template<typename T, typename Cmp=std::less<T>>
+class CQValueIndex {
+ public:
+  using Values = std::vector<T>;
+  using Counts = std::vector<int>;
+
+ public:
+  CQValueIndex() = default;
+
+  void clear() {
+    ids_   .clear();
+    values_.clear();
+    counts_.clear();
+  }
+
+  //! number of unique values
+  int size() const { return int(values_.size()); }
+
+  bool empty() const { return values_.empty(); }
+
+  //! add value and return its id
+  int add(const T &v) {
+    auto p = ids_.find(v);
+
+    if (p == ids_.end()) {
+      int id = int(values_.size());
+
+      p = ids_.insert(p, typename IdMap::value_type(v, id));
+
+      values_.push_back(v);
+      counts_.push_back(0);
+    }
+
+    ++counts_[size_t((*p).second)];
+
+    return (*p).second;
+  }
+
+  //! id of value (-1 if not found)
+  int id(const T &v) const {
+    auto p = ids_.find(v);
+
+    if (p == ids_.end())
+      return -1;
+
+    return (*p).second;
+  }
+
+  //! value for id (def if invalid)
+  T value(int id, const T &def=T()) const {
+    if (id < 0 || id >= size())
+      return def;
+
+    return values_[size_t(id)];
+  }
+
+  //! number of additions of value for id
+  int count(int id) const {
+    if (id < 0 || id >= size())
+      return 0;
+
+    return counts_[size_t(id)];
+  }
+
+  //! values and counts in id order
+  const Values &values() const { return values_; }
+  const Counts &counts() const { return counts_; }
+
+  //! values and counts in value order
+  void sortedValues(Values &values) const {
+    for (const auto &vi : ids_)
+      values.push_back(vi.first);
+  }
+
+  void sortedCounts(Counts &counts) const {
+    for (const auto &vi : ids_)
+      counts.push_back(counts_[size_t(vi.second)]);
+  }
+
+ private:
+  using IdMap = std::map<T, int, Cmp>;
+
+  IdMap  ids_;    //!< id for value
+  Values values_; //!< value for id
+  Counts counts_; //!< count for id
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define CQValueSet_H
 
 #include <CQStatData.h>
+#include <CQValueIndex.h>
 #include <CQBaseModelTypes.h>
 #include <CMathUtil.h>
 #include <CSafeIndex.h>
@@ -12,9 +13,6 @@
 #include <future>
 #include <optional>
 
-class CQTrie;
-class CQTriePatterns;
-
 //------
 
 /*!
@@ -33,46 +31,46 @@ class CQRValues {
   void clear() {
     values_ .clear();
     svalues_.clear();
-    valset_ .clear();
-    setvals_.clear();
+    valueIndex_.clear();
+
+    numNull_ = 0;
+
+    minValue_.reset();
+    maxValue_.reset();
 
-    numNull_    = 0;
     calculated_ = false;
+
+    calcValid_  .store(false);
+    uniqueValid_.store(false);
   }
 
   bool isValid() const { return ! values_.empty(); }
 
-  bool canMap() const { return ! valset_.empty(); }
+  bool canMap() const { return size() > numNull(); }
 
   int size() const { return int(values_.size()); }
 
   // get nth value (non-unique)
   const OptReal &value(int i) const { return CUtil::safeIndex(values_, i); }
 
-  int addValue(const OptReal &r);
+  void addValue(const OptReal &r);
 
   int numNull() const { return numNull_; }
 
   // real to id
   int id(double r) const {
     // get real set index
-    auto p = valset_.find(r);
+    initUnique();
 
-    if (p == valset_.end())
-      return -1;
-
-    return (*p).second.first;
+    return valueIndex_.id(r);
   }
 
   // id to real
   double ivalue(int i) const {
     // get real for index
-    auto p = setvals_.find(i);
-
-    if (p == setvals_.end())
-      return 0.0;
+    initUnique();
 
-    return (*p).second;
+    return valueIndex_.value(i, 0.0);
   }
 
   // map value into real in range
@@ -88,28 +86,28 @@ class CQRValues {
   }
 
   // min/max value
-  double min(double def=CMathUtil::getNaN()) const {
-    return (valset_.empty() ? def : valset_. begin()->first);
-  }
-  double max(double def=CMathUtil::getNaN()) const {
-    return (valset_.empty() ? def : valset_.rbegin()->first);
-  }
+  double min(double def=CMathUtil::getNaN()) const { return (minValue_ ? *minValue_ : def); }
+  double max(double def=CMathUtil::getNaN()) const { return (maxValue_ ? *maxValue_ : def); }
 
   // min/max index
-  int imin(int def=0) const { return (setvals_.empty() ? def : setvals_. begin()->first); }
-  int imax(int def=0) const { return (setvals_.empty() ? def : setvals_.rbegin()->first); }
+  int imin(int def=0) const { initUnique(); return (valueIndex_.empty() ? def : 0); }
+  int imax(int def=0) const {
+    initUnique(); return (valueIndex_.empty() ? def : valueIndex_.size() - 1); }
 
   // number of unique values
-  int numUnique() const { return int(valset_.size()); }
+  int numUnique() const { initUnique(); return valueIndex_.size(); }
 
+  // unique values/counts (in value order)
   void uniqueValues(Values &values) {
-    for (const auto &vi : valset_)
-      values.push_back(vi.first);
+    initUnique();
+
+    valueIndex_.sortedValues(values);
   }
 
   void uniqueCounts(Counts &counts) {
-    for (const auto &vi : valset_)
-      counts.push_back(vi.second.second);
+    initUnique();
+
+    valueIndex_.sortedCounts(counts);
   }
 
   // calculated stats
@@ -130,6 +128,23 @@ class CQRValues {
   double svalue(int i) const { return CUtil::safeIndex(svalues_, i); }
 
  private:
+  // unique values are only indexed when first needed
+  void initUnique() const {
+    if (! uniqueValid_.load()) {
+      std::unique_lock<std::mutex> lock(uniqueMutex_);
+
+      if (! uniqueValid_.load()) {
+        auto *th = const_cast<CQRValues *>(this);
+
+        th->calcUnique();
+
+        uniqueValid_.store(true);
+      }
+    }
+  }
+
+  void calcUnique();
+
   void initCalc() const {
     if (! calcValid_.load()) {
       std::unique_lock<std::mutex> lock(calcMutex_);
@@ -157,20 +172,21 @@ class CQRValues {
   };
 
   using OptValues = std::vector<OptReal>;
-  using KeyCount  = std::pair<int, int>;
-  using ValueSet  = std::map<double, KeyCount, RealCmp>;
-  using SetValues = std::map<int, double>;
-
-  OptValues                 values_;               //!< all real values
-  Values                    svalues_;              //!< sorted real values
-  ValueSet                  valset_;               //!< unique indexed real values
-  SetValues                 setvals_;              //!< index to real map
-  int                       numNull_    { 0 };     //!< number of null values
-  bool                      calculated_ { false }; //!< are stats calculated
-  CQStatData                statData_;             //!< stat data
-  Indices                   outliers_;             //!< outlier values
-  mutable std::atomic<bool> calcValid_  { false }; //!< is calculated
-  mutable std::mutex        calcMutex_;            //!< calc mutex
+  using ValueIndex = CQValueIndex<double, RealCmp>;
+
+  OptValues                 values_;                //!< all real values
+  Values                    svalues_;               //!< sorted real values
+  ValueIndex                valueIndex_;            //!< unique indexed real values
+  int                       numNull_     { 0 };     //!< number of null values
+  bool                      calculated_  { false }; //!< are stats calculated
+  CQStatData                statData_;              //!< stat data
+  Indices                   outliers_;              //!< outlier values
+  OptReal                   minValue_;              //!< min value
+  OptReal                   maxValue_;              //!< max value
+  mutable std::atomic<bool> calcValid_   { false }; //!< is calculated
+  mutable std::mutex        calcMutex_;             //!< calc mutex
+  mutable std::atomic<bool> uniqueValid_ { false }; //!< are unique values indexed
+  mutable std::mutex        uniqueMutex_;           //!< unique values mutex
 };
 
 //---
@@ -191,46 +207,46 @@ class CQIValues {
   void clear() {
     values_ .clear();
     svalues_.clear();
-    valset_ .clear();
-    setvals_.clear();
+    valueIndex_.clear();
+
+    numNull_ = 0;
+
+    minValue_.reset();
+    maxValue_.reset();
 
-    numNull_    = 0;
     calculated_ = false;
+
+    calcValid_  .store(false);
+    uniqueValid_.store(false);
   }
 
   bool isValid() const { return ! values_.empty(); }
 
-  bool canMap() const { return ! valset_.empty(); }
+  bool canMap() const { return size() > numNull(); }
 
   int size() const { return int(values_.size()); }
 
   // get nth value (non-unique)
   const OptInt &value(int i) const { return CUtil::safeIndex(values_, i); }
 
-  int addValue(const OptInt &i);
+  void addValue(const OptInt &i);
 
   int numNull() const { return numNull_; }
 
   // integer to id
   int id(long i) const {
     // get integer set index
-    auto p = valset_.find(i);
+    initUnique();
 
-    if (p == valset_.end())
-      return -1;
-
-    return (*p).second.first;
+    return valueIndex_.id(i);
   }
 
   // id to integer
   long ivalue(int i) const {
     // get integer for index
-    auto p = setvals_.find(i);
-
-    if (p == setvals_.end())
-      return 0;
+    initUnique();
 
-    return (*p).second;
+    return valueIndex_.value(i, 0);
   }
 
   // map value into real in range
@@ -246,24 +262,28 @@ class CQIValues {
   }
 
   // min/max value
-  long min(long def=0) const { return (valset_.empty() ? def : valset_. begin()->first); }
-  long max(long def=0) const { return (valset_.empty() ? def : valset_.rbegin()->first); }
+  long min(long def=0) const { return (minValue_ ? *minValue_ : def); }
+  long max(long def=0) const { return (maxValue_ ? *maxValue_ : def); }
 
   // min/max index
-  int imin(int def=0) const { return (setvals_.empty() ? def : setvals_. begin()->first); }
-  int imax(int def=0) const { return (setvals_.empty() ? def : setvals_.rbegin()->first); }
+  int imin(int def=0) const { initUnique(); return (valueIndex_.empty() ? def : 0); }
+  int imax(int def=0) const {
+    initUnique(); return (valueIndex_.empty() ? def : valueIndex_.size() - 1); }
 
   // number of unique values
-  int numUnique() const { return int(valset_.size()); }
+  int numUnique() const { initUnique(); return valueIndex_.size(); }
 
+  // unique values/counts (in value order)
   void uniqueValues(Values &values) {
-    for (const auto &vi : valset_)
-      values.push_back(vi.first);
+    initUnique();
+
+    valueIndex_.sortedValues(values);
   }
 
   void uniqueCounts(Counts &counts) {
-    for (const auto &vi : valset_)
-      counts.push_back(vi.second.second);
+    initUnique();
+
+    valueIndex_.sortedCounts(counts);
   }
 
   // calculated stats
@@ -284,6 +304,23 @@ class CQIValues {
   long svalue(int i) const { return CUtil::safeIndex(svalues_, i); }
 
  private:
+  // unique values are only indexed when first needed
+  void initUnique() const {
+    if (! uniqueValid_.load()) {
+      std::unique_lock<std::mutex> lock(uniqueMutex_);
+
+      if (! uniqueValid_.load()) {
+        auto *th = const_cast<CQIValues *>(this);
+
+        th->calcUnique();
+
+        uniqueValid_.store(true);
+      }
+    }
+  }
+
+  void calcUnique();
+
   void initCalc() const {
     if (! calcValid_.load()) {
       std::unique_lock<std::mutex> lock(calcMutex_);
@@ -302,20 +339,21 @@ class CQIValues {
 
  private:
   using OptValues = std::vector<OptInt>;
-  using KeyCount  = std::pair<int, int>;
-  using ValueSet  = std::map<long, KeyCount>;
-  using SetValues = std::map<int, long>;
-
-  OptValues                 values_;               //!< all integer values
-  Values                    svalues_;              //!< sorted integer values
-  ValueSet                  valset_;               //!< unique indexed integer values
-  SetValues                 setvals_;              //!< index to integer map
-  int                       numNull_    { 0 };     //!< number of null values
-  bool                      calculated_ { false }; //!< are stats calculated
-  CQStatData                statData_;             //!< stat data
-  Indices                   outliers_;             //!< outlier values
-  mutable std::atomic<bool> calcValid_  { false }; //!< is calculated
-  mutable std::mutex        calcMutex_;            //!< calc mutex
+  using ValueIndex = CQValueIndex<long>;
+
+  OptValues                 values_;                //!< all integer values
+  Values                    svalues_;               //!< sorted integer values
+  ValueIndex                valueIndex_;            //!< unique indexed integer values
+  int                       numNull_     { 0 };     //!< number of null values
+  bool                      calculated_  { false }; //!< are stats calculated
+  CQStatData                statData_;              //!< stat data
+  Indices                   outliers_;              //!< outlier values
+  OptInt                    minValue_;              //!< min value
+  OptInt                    maxValue_;              //!< max value
+  mutable std::atomic<bool> calcValid_   { false }; //!< is calculated
+  mutable std::mutex        calcMutex_;             //!< calc mutex
+  mutable std::atomic<bool> uniqueValid_ { false }; //!< are unique values indexed
+  mutable std::mutex        uniqueMutex_;           //!< unique values mutex
 };
 
 //---
@@ -337,65 +375,60 @@ class CQSValues {
 
   bool isValid() const { return ! values_.empty(); }
 
-  bool canMap() const { return ! valset_.empty(); }
+  bool canMap() const { return size() > numNull(); }
 
   int size() const { return int(values_.size()); }
 
   // get nth value (non-unique)
   const OptString &value(int i) const { return CUtil::safeIndex(values_, i); }
 
-  int addValue(const OptString &s);
+  void addValue(const OptString &s);
 
   int numNull() const { return numNull_; }
 
   // string to id
   int id(const QString &s) const {
     // get string set index
-    auto p = valset_.find(s);
-
-    if (p == valset_.end())
-      return -1;
+    initUnique();
 
-    return (*p).second.first;
+    return valueIndex_.id(s);
   }
 
   // id to string
   QString ivalue(int i) const {
     // get string for index
-    auto p = setvals_.find(i);
+    initUnique();
 
-    if (p == setvals_.end())
-      return "";
-
-    return (*p).second;
+    return valueIndex_.value(i, "");
   }
 
   // min/max value
-  QString min(const QString &def="") const {
-    return (valset_.empty() ? def : valset_. begin()->first);
-  }
-  QString max(const QString &def="") const {
-    return (valset_.empty() ? def : valset_.rbegin()->first);
-  }
+  QString min(const QString &def="") const { return (minValue_ ? *minValue_ : def); }
+  QString max(const QString &def="") const { return (maxValue_ ? *maxValue_ : def); }
 
   // min/max index
-  int imin(int def=0) const { return (setvals_.empty() ? def : setvals_. begin()->first); }
-  int imax(int def=0) const { return (setvals_.empty() ? def : setvals_.rbegin()->first); }
+  int imin(int def=0) const { initUnique(); return (valueIndex_.empty() ? def : 0); }
+  int imax(int def=0) const {
+    initUnique(); return (valueIndex_.empty() ? def : valueIndex_.size() - 1); }
 
   // number of unique values
-  int numUnique() const { return int(valset_.size()); }
+  int numUnique() const { initUnique(); return valueIndex_.size(); }
 
+  // unique values/counts (in id order)
   void uniqueValues(Values &values) {
-    for (const auto &sv : setvals_)
-      values.push_back(sv.second);
+    initUnique();
+
+    const auto &ivalues = valueIndex_.values();
+
+    values.insert(values.end(), ivalues.begin(), ivalues.end());
   }
 
   void uniqueCounts(Counts &counts) {
-    for (const auto &sv : setvals_) {
-      auto p = valset_.find(sv.second);
+    initUnique();
 
-      counts.push_back((*p).second.second);
-    }
+    const auto &icounts = valueIndex_.counts();
+
+    counts.insert(counts.end(), icounts.begin(), icounts.end());
   }
 
   // map value into real in range
@@ -412,29 +445,58 @@ class CQSValues {
     return CMathUtil::map(i, imin(), imax(), mapMin, mapMax);
   }
 
+  // string bucket (index of common prefix pattern)
   int sbucket(const QString &s) const;
 
+  // bucket for unique string id
+  int ibucket(int id) const;
+
+  // bucket pattern (common prefix with trailing '*' if strings are longer)
   QString buckets(int i) const;
 
+  // number of buckets
+  int numBuckets() const;
+
  private:
+  // unique values are only indexed when first needed
+  void initUnique() const {
+    if (! uniqueValid_.load()) {
+      std::unique_lock<std::mutex> lock(uniqueMutex_);
+
+      if (! uniqueValid_.load()) {
+        auto *th = const_cast<CQSValues *>(this);
+
+        th->calcUnique();
+
+        uniqueValid_.store(true);
+      }
+    }
+  }
+
+  void calcUnique();
+
   void initPatterns(int numIdeal) const;
 
  private:
-  using OptValues = std::vector<OptString>;
-  using KeyCount  = std::pair<int, int>;
-  using ValueSet  = std::map<QString, KeyCount>;
-  using SetValues = std::map<int, QString>;
-
-  OptValues values_;        //!< all string values
-  ValueSet  valset_;        //!< unique indexed string values
-  SetValues setvals_;       //!< index to string map
-  int       numNull_ { 0 }; //!< number of null values
-
-  int                   initBuckets_  { 10 };      //!< initial buckets
-  CQTrie*         trie_         { nullptr }; //!< string trie
-  CQTriePatterns* spatterns_    { nullptr }; //!< trie patterns
-  bool                  spatternsSet_ { false };   //!< trie patterns set
-  mutable std::mutex    mutex_;                    //!< mutex
+  using OptValues  = std::vector<OptString>;
+  using ValueIndex = CQValueIndex<QString>;
+  using BucketIds  = std::vector<int>;
+  using Patterns   = std::vector<QString>;
+
+  OptValues  values_;        //!< all string values
+  ValueIndex valueIndex_;    //!< unique indexed string values
+  int        numNull_ { 0 }; //!< number of null values
+  OptString  minValue_;      //!< min value
+  OptString  maxValue_;      //!< max value
+
+  mutable std::atomic<bool> uniqueValid_ { false }; //!< are unique values indexed
+  mutable std::mutex        uniqueMutex_;           //!< unique values mutex
+
+  int                initBuckets_  { 10 };    //!< initial buckets
+  BucketIds          bucketIds_;              //!< bucket per unique string id
+  Patterns           spatterns_;              //!< sorted bucket patterns
+  bool               spatternsSet_ { false }; //!< bucket patterns set
+  mutable std::mutex mutex_;                  //!< mutex
 };
 
 //------
@@ -467,15 +529,15 @@ class CQValueSet : public QObject {
 
   // get/set mapping enabled
   bool isMapped() const { return mapped_; }
-  void setMapped(bool b) { mapped_ = b; }
+  void setMapped(bool b) { mapped_ = b; resetMapValues(); }
 
   // get/set map min value
   double mapMin() const { return map_min_; }
-  void setMapMin(double r) { map_min_ = r; }
+  void setMapMin(double r) { map_min_ = r; resetMapValues(); }
 
   // get/set map max value
   double mapMax() const { return map_max_; }
-  void setMapMax(double r) { map_max_ = r; }
+  void setMapMax(double r) { map_max_ = r; resetMapValues(); }
 
   //---
 
@@ -500,7 +562,7 @@ class CQValueSet : public QObject {
 
   // get type
   Type type() const { init(); return type_; }
-  void setType(const Type &type) { type_ = type; }
+  void setType(const Type &type) { type_ = type; resetMapValues(); }
 
   bool isReal   () const { return (type() == Type::REAL   ); }
   bool isInteger() const { return (type() == Type::INTEGER); }
@@ -539,8 +601,13 @@ class CQValueSet : public QObject {
   double imap(const QVariant &value) const;
 
   // map nth value to real range (mapMin()->mapMax())
+  // (uses cached mapped values)
   double imap(int i) const;
 
+  // copy mapped values (mapMin()->mapMax()) of first n values into array.
+  // Returns number of values copied
+  int imapAll(double *values, int n) const;
+
   // map nth value to real range (min->max)
   double imap(int i, double min, double max) const;
 
@@ -601,8 +668,13 @@ class CQValueSet : public QObject {
 
   Type calcType() const;
 
+  void initMapValues() const;
+
+  void resetMapValues() { mapValuesValid_ = false; }
+
  protected:
-  using Values = std::vector<QVariant>;
+  using Values    = std::vector<QVariant>;
+  using MapValues = std::vector<double>;
 
   int column_ { -1 }; //!< associated model column
 
@@ -621,6 +693,9 @@ class CQValueSet : public QObject {
 
   bool allowNaN_ { false }; //!< allow NaN values
 
+  MapValues mapValues_;                //!< mapped value per input value
+  bool      mapValuesValid_ { false }; //!< are mapped values valid
+
   mutable std::mutex mutex_; //!< mutex
 };
 
@@ -39,7 +39,23 @@ void
 CQSelModel::
 setSourceModel(QAbstractItemModel *sourceModel)
 {
+  if (sourceModel_)
+    disconnect(sourceModel_, nullptr, this, nullptr);
+
   sourceModel_ = sourceModel;
+
+  if (sourceModel_) {
+    connect(sourceModel_, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+            this, SLOT(sourceRowsInserted(const QModelIndex &, int, int)));
+    connect(sourceModel_, SIGNAL(rowsRemoved(const QModelIndex &, int, int)),
+            this, SLOT(sourceRowsRemoved(const QModelIndex &, int, int)));
+    connect(sourceModel_, SIGNAL(layoutAboutToBeChanged()),
+            this, SLOT(sourceLayoutAboutToBeChanged()));
+    connect(sourceModel_, SIGNAL(layoutChanged()), this, SLOT(sourceLayoutChanged()));
+    connect(sourceModel_, SIGNAL(modelReset()), this, SLOT(sourceReset()));
+  }
+
+  sourceReset();
 }
 
 //------
@@ -139,7 +155,14 @@ setData(const QModelIndex &index, const QVariant &value, int role)
 
   if (c == 0) {
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
-      setSelected(index, value.toBool());
+      bool selected = value.toBool();
+
+      if (selected != isSelected(index)) {
+        setSelected(index, selected);
+
+        emitSelectedChanged(index.row(), index.row());
+      }
+
       return true;
     }
 
@@ -169,11 +192,7 @@ headerData(int section, Qt::Orientation orientation, int role) const
       return "";
     }
     else if (role == Qt::DecorationRole) {
-      int numSelected { 0 };
-
-      for (const auto &ps : selected_)
-        if (ps.second)
-          ++numSelected;
+      int numSelected = this->numSelected();
 
       if      (numSelected == 0)
         return uncheckedIcon_;
@@ -295,19 +314,167 @@ bool
 CQSelModel::
 isSelected(const QModelIndex &ind) const
 {
-  auto p = selected_.find(ind);
+  return isRowSelected(ind.row());
+}
 
-  if (p != selected_.end())
-    return (*p).second;
+void
+CQSelModel::
+setSelected(const QModelIndex &ind, bool selected)
+{
+  setRowSelected(ind.row(), selected);
+}
 
-  return false;
+bool
+CQSelModel::
+isRowSelected(int row) const
+{
+  return selected_.test(row);
 }
 
 void
 CQSelModel::
-setSelected(const QModelIndex &ind, bool selected)
+setRowSelected(int row, bool selected)
+{
+  updateSelectedRows();
+
+  selected_.set(row, selected);
+}
+
+void
+CQSelModel::
+setRowsSelected(int r1, int r2, bool selected)
+{
+  updateSelectedRows();
+
+  selected_.setRange(r1, r2, selected);
+
+  emitSelectedChanged(r1, r2);
+}
+
+void
+CQSelModel::
+setSelectedRows(const CQSelRowBits &rows)
+{
+  updateSelectedRows();
+
+  int r1, r2;
+
+  if (! selected_.diffRange(rows, r1, r2))
+    return;
+
+  selected_ = rows;
+
+  // source row count could differ from rows
+  updateSelectedRows();
+
+  emitSelectedChanged(r1, r2);
+}
+
+void
+CQSelModel::
+emitSelectedChanged(int r1, int r2)
+{
+  r1 = std::max(r1, 0);
+  r2 = std::min(r2, rowCount() - 1);
+
+  if (r1 <= r2)
+    Q_EMIT dataChanged(index(r1, 0, QModelIndex()), index(r2, 0, QModelIndex()));
+
+  // update all/none/partial state
+  Q_EMIT headerDataChanged(Qt::Horizontal, 0, 0);
+}
+
+void
+CQSelModel::
+updateSelectedRows()
 {
-  selected_[ind] = selected;
+  // rows added without notification are not selected
+  int nr = rowCount();
+
+  if (selected_.size() != nr)
+    selected_.resize(nr);
+}
+
+//---
+
+void
+CQSelModel::
+sourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+  if (parent.isValid())
+    return;
+
+  selected_.insertRows(first, last - first + 1);
+}
+
+void
+CQSelModel::
+sourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+  if (parent.isValid())
+    return;
+
+  selected_.removeRows(first, last - first + 1);
+}
+
+void
+CQSelModel::
+sourceLayoutAboutToBeChanged()
+{
+  layoutSelected_.clear();
+
+  // save selected rows as persistent indices (need a column for index)
+  auto *model = this->sourceModel();
+
+  layoutPersistent_ = (model && model->columnCount(QModelIndex()) > 0);
+
+  if (! layoutPersistent_)
+    return;
+
+  int nr = std::min(selected_.size(), model->rowCount(QModelIndex()));
+
+  for (int r = 0; r < nr; ++r) {
+    if (selected_.test(r))
+      layoutSelected_.push_back(QPersistentModelIndex(model->index(r, 0, QModelIndex())));
+  }
+}
+
+void
+CQSelModel::
+sourceLayoutChanged()
+{
+  if (layoutPersistent_) {
+    // reselect moved rows (removed rows have invalid index)
+    selected_.resize(0);
+
+    updateSelectedRows();
+
+    for (const auto &ind : layoutSelected_) {
+      if (ind.isValid())
+        selected_.set(ind.row(), true);
+    }
+
+    layoutSelected_.clear();
+
+    layoutPersistent_ = false;
+  }
+  else {
+    // no saved rows so keep selection if rows still match
+    if (selected_.size() != rowCount())
+      sourceReset();
+  }
+
+  emitSelectedChanged(0, rowCount() - 1);
+}
+
+void
+CQSelModel::
+sourceReset()
+{
+  // rows no longer match
+  selected_.resize(0);
+
+  updateSelectedRows();
 }
 
 //---
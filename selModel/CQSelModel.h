@@ -1,13 +1,20 @@
 #ifndef CQSelModel_H
 #define CQSelModel_H
 
+#include <CQSelRowBits.h>
 #include <QAbstractItemModel>
+#include <QPersistentModelIndex>
 #include <QIcon>
+#include <vector>
 
 class CQSelView;
 
 /*!
  * \brief add extra selection state column to model
+ *
+ * Selection state is stored per source row (bitset with number of selected rows)
+ * and is kept in sync when source rows are inserted or removed. Selected rows are
+ * tracked by persistent index over a source layout change (e.g. sort).
  */
 class CQSelModel : public QAbstractItemModel {
   Q_OBJECT
@@ -71,16 +78,44 @@ class CQSelModel : public QAbstractItemModel {
   bool isSelected (const QModelIndex &ind) const;
   void setSelected(const QModelIndex &ind, bool selected);
 
+  bool isRowSelected (int row) const;
+  void setRowSelected(int row, bool selected);
+
+  //! set selected state of rows r1 to r2 (inclusive)
+  void setRowsSelected(int r1, int r2, bool selected);
+
+  //! set selected rows (single data changed signal for changed rows)
+  void setSelectedRows(const CQSelRowBits &rows);
+
+  //! get number of selected rows
+  int numSelected() const { return selected_.count(); }
+
   //---
 
   void reset();
 
+ private slots:
+  void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+  void sourceRowsRemoved (const QModelIndex &parent, int first, int last);
+
+  void sourceLayoutAboutToBeChanged();
+  void sourceLayoutChanged();
+
+  void sourceReset();
+
  private:
-  using Selected = std::map<QModelIndex, bool>;
+  using LayoutIndices = std::vector<QPersistentModelIndex>;
+
+  void updateSelectedRows();
 
+  void emitSelectedChanged(int r1, int r2);
+
+ private:
   CQSelView*          view_        { nullptr };
   QAbstractItemModel* sourceModel_ { nullptr };
-  Selected            selected_;
+  CQSelRowBits        selected_;
+  LayoutIndices       layoutSelected_;
+  bool                layoutPersistent_ { false };
   QIcon               checkedIcon_;
   QIcon               uncheckedIcon_;
   QIcon               partCheckedIcon_;
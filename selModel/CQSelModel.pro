@@ -9,6 +9,7 @@ CQSelDelegate.cpp \
 
 HEADERS += \
 CQSelModel.h \
+CQSelRowBits.h \
 CQSelView.h \
 CQSelDelegate.h \
 
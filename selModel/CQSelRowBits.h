@@ -0,0 +1,165 @@
+#ifndef CQSelRowBits_H
+#define CQSelRowBits_H
+
+#include <vector>
+#include <bitset>
+#include <algorithm>
+#include <cstdint>
+
+/*!
+ * \brief row indexed bitset with maintained number of set bits
+ *
+ * test/set and count are O(1), ranges are set a word at a time.
+ */
+class CQSelRowBits {
+ public:
+  CQSelRowBits() = default;
+
+  //! number of rows
+  int size() const { return numRows_; }
+
+  //! number of set rows
+  int count() const { return count_; }
+
+  bool none() const { return count_ == 0; }
+  bool all () const { return count_ == numRows_; }
+
+  //! set number of rows (new rows are not set)
+  void resize(int n) {
+    n = std::max(n, 0);
+
+    if (n < numRows_)
+      setRange(n, numRows_ - 1, false);
+
+    words_.resize(size_t((n + 63)/64));
+
+    numRows_ = n;
+  }
+
+  //! unset all rows
+  void clear() {
+    std::fill(words_.begin(), words_.end(), 0);
+
+    count_ = 0;
+  }
+
+  //! is row set
+  bool test(int row) const {
+    if (row < 0 || row >= numRows_)
+      return false;
+
+    return (words_[size_t(row/64)] & bit(row)) != 0;
+  }
+
+  //! set row
+  void set(int row, bool b) {
+    if (row < 0 || row >= numRows_)
+      return;
+
+    auto &word = words_[size_t(row/64)];
+
+    bool b1 = ((word & bit(row)) != 0);
+    if (b1 == b) return;
+
+    if (b) { word |=  bit(row); ++count_; }
+    else   { word &= ~bit(row); --count_; }
+  }
+
+  //! set rows r1 to r2 (inclusive)
+  void setRange(int r1, int r2, bool b) {
+    r1 = std::max(r1, 0);
+    r2 = std::min(r2, numRows_ - 1);
+
+    for (int r = r1; r <= r2; ) {
+      int b1 = r % 64;
+      int b2 = std::min(63, b1 + (r2 - r));
+
+      auto mask = (b2 - b1 == 63 ? ~Word(0) : ((Word(1) << (b2 - b1 + 1)) - 1) << b1);
+
+      auto &word = words_[size_t(r/64)];
+
+      count_ -= popCount(word & mask);
+
+      if (b) word |=  mask;
+      else   word &= ~mask;
+
+      count_ += popCount(word & mask);
+
+      r += b2 - b1 + 1;
+    }
+  }
+
+  //! get first and last rows with different state in rhs (false if none)
+  bool diffRange(const CQSelRowBits &rhs, int &r1, int &r2) const {
+    r1 = -1; r2 = -1;
+
+    auto nw = std::max(words_.size(), rhs.words_.size());
+
+    for (size_t i = 0; i < nw; ++i) {
+      auto w1 = (i < words_    .size() ? words_    [i] : Word(0));
+      auto w2 = (i < rhs.words_.size() ? rhs.words_[i] : Word(0));
+
+      auto d = w1 ^ w2;
+      if (! d) continue;
+
+      if (r1 < 0)
+        r1 = int(i)*64 + lowBit(d);
+
+      r2 = int(i)*64 + highBit(d);
+    }
+
+    return (r1 >= 0);
+  }
+
+  //! insert n unset rows at row (later rows move down)
+  void insertRows(int row, int n) {
+    if (n <= 0) return;
+
+    row = std::min(std::max(row, 0), numRows_);
+
+    resize(numRows_ + n);
+
+    for (int r = numRows_ - 1; r >= row + n; --r)
+      set(r, test(r - n));
+
+    setRange(row, row + n - 1, false);
+  }
+
+  //! remove n rows at row (later rows move up)
+  void removeRows(int row, int n) {
+    if (row < 0 || n <= 0 || row >= numRows_) return;
+
+    n = std::min(n, numRows_ - row);
+
+    for (int r = row; r < numRows_ - n; ++r)
+      set(r, test(r + n));
+
+    resize(numRows_ - n);
+  }
+
+ private:
+  using Word  = uint64_t;
+  using Words = std::vector<Word>;
+
+  static Word bit(int row) { return Word(1) << (row % 64); }
+
+  static int popCount(Word w) { return int(std::bitset<64>(w).count()); }
+
+  static int lowBit(Word w) { return popCount((w & (~w + 1)) - 1); }
+
+  static int highBit(Word w) {
+    int b = 63;
+
+    while (b > 0 && ! (w & (Word(1) << b)))
+      --b;
+
+    return b;
+  }
+
+ private:
+  Words words_;         //!< row bits
+  int   numRows_ { 0 }; //!< number of rows
+  int   count_   { 0 }; //!< number of set rows
+};
+
+#endif
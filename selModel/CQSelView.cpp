@@ -4,7 +4,6 @@
 
 #include <QSortFilterProxyModel>
 #include <QHeaderView>
-#include <set>
 
 CQSelView::
 CQSelView(QWidget *parent) :
@@ -77,24 +76,34 @@ updateModelFromSelection()
 
   //---
 
-  auto inds = sm->selectedIndexes();
+  // set rows of selection ranges (in sel model rows) and apply changes in one update
+  const auto &selection = sm->selection();
 
-  std::set<int> rows;
+  CQSelRowBits rows;
 
-  for (const auto &ind : inds) {
-    auto ind1 = sortModel_->mapToSource(ind);
+  rows.resize(selModel_->rowCount());
 
-    rows.insert(ind1.row());
-  }
+  // unsorted and unfiltered proxy rows are sel model rows so use ranges directly,
+  // otherwise map each proxy row of range (column 0) to sel model row
+  bool identity = (sortModel_->sortColumn() < 0 &&
+                   sortModel_->rowCount() == selModel_->rowCount());
 
-  for (int r = 0; r < selModel_->rowCount(); ++r) {
-    bool sel = (rows.find(r) != rows.end());
+  for (const auto &range : selection) {
+    if (identity) {
+      rows.setRange(range.top(), range.bottom(), true);
+      continue;
+    }
 
-    auto ind = selModel_->index(r, 0, QModelIndex());
+    for (int r = range.top(); r <= range.bottom(); ++r) {
+      auto ind = sortModel_->mapToSource(sortModel_->index(r, 0, range.parent()));
 
-    selModel_->setData(ind, QVariant(sel), Qt::DisplayRole);
+      if (ind.isValid())
+        rows.set(ind.row(), true);
+    }
   }
 
+  selModel_->setSelectedRows(rows);
+
   //---
 
   connect(sm, SIGNAL(selectionChanged(const QItemSelection &, const QItemSelection &)),
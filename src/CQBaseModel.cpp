@@ -5,7 +5,11 @@
 
 #include <QApplication>
 #include <QThread>
+#include <QHash>
 
+#include <unordered_set>
+#include <algorithm>
+#include <thread>
 #include <cmath>
 #include <cassert>
 
@@ -19,6 +23,11 @@ static TypeName  s_typeName;
 static NameType  s_nameType;
 static AliasName s_aliasName;
 
+//! hash for variant key string
+struct VariantKeyHash {
+  size_t operator()(const QString &s) const { return size_t(qHash(s)); }
+};
+
 void addType(CQBaseModelType type, const QString &name) {
   s_typeName[type] = name;
   s_nameType[name] = type;
@@ -84,6 +93,12 @@ CQBaseModel(QObject *parent) :
   initTypes();
 }
 
+CQBaseModel::
+~CQBaseModel()
+{
+  cancelRefineColumnTypes(/*restart*/false);
+}
+
 //---
 
 void
@@ -92,9 +107,26 @@ copyModel(CQBaseModel *model)
 {
   beginResetModel();
 
-  // data
-  columnDatas_ = model->columnDatas_;
-  rowDatas_    = model->rowDatas_;
+  // data (O(columns), cached role values and row datas shared copy on write)
+  {
+  ReadLock  modelLock(model->mutex_);
+  WriteLock lock(mutex_);
+
+  columnDatas_.clear();
+
+  for (const auto &columnData : model->columnDatas_)
+    columnDatas_.push_back(std::make_unique<ColumnData>(*columnData));
+
+  // no readers during reset so old tables and column datas can be freed
+  columnTables_.clear();
+
+  retiredColumnDatas_.clear();
+
+  updateColumnTable();
+
+  rowDatas_ = model->rowDatas_;
+  }
+
   dataType_    = model->dataType_;
 
   metaNameValues_ = model->metaNameValues_;
@@ -132,6 +164,11 @@ void
 CQBaseModel::
 genColumnType(const ColumnData &columnData) const
 {
+  // type being calculated by this thread (re-entrant call from value read of calculation).
+  // Other threads wait on type mutex for calculated type
+  if (isTypeCalcThread(columnData))
+    return;
+
   if (columnData.type == CQBaseModelType::NONE) {
     std::unique_lock<std::mutex> lock(typeMutex_);
 
@@ -154,14 +191,23 @@ genColumnTypeI(ColumnData &columnData)
 
   //---
 
-  columnData.type     = CQBaseModelType::STRING;
-  columnData.baseType = CQBaseModelType::STRING;
+  // values are read raw (unconverted) by calculating thread
+  columnData.typeCalcThread = std::this_thread::get_id();
 
   //---
 
   ColumnTypeData columnTypeData;
 
-  columnTypeData.type = CQModelUtil::calcColumnType(this, columnData.column, maxRows);
+  CQModelUtil::ColumnTypeSample sample;
+
+  sample.type    = typeSample();
+  sample.maxRows = maxRows;
+  sample.maxTime = maxTypeTime();
+  sample.role    = Qt::DisplayRole; // raw values (parallel scan threads do not need type)
+
+  bool complete;
+
+  columnTypeData.type = CQModelUtil::calcColumnType(this, columnData.column, sample, &complete);
 
   // if inderminate (no values or all reals or integers) then use real if any reals,
   // integer if any integers and string if no values.
@@ -176,10 +222,244 @@ genColumnTypeI(ColumnData &columnData)
 
   columnTypeData.baseType = columnTypeData.type;
 
-  if (columnTypeData.type != columnData.type) {
-    columnData.type     = columnTypeData.type;
-    columnData.baseType = columnTypeData.baseType;
+  // type from sample could be promoted by other rows so check all rows later
+  columnData.typeProvisional = ! complete;
+
+  // publish type last as readers only lock when type is not set
+  columnData.baseType = columnTypeData.baseType;
+  columnData.type     = columnTypeData.type;
+
+  columnData.typeCalcThread = std::thread::id();
+
+  // provisional types are only refined automatically when async types are enabled
+  // (otherwise caller opts in with refineColumnType(s))
+  if (! complete && isAsyncTypes())
+    scheduleRefineColumnTypes();
+}
+
+void
+CQBaseModel::
+scheduleRefineColumnTypes()
+{
+  // queue single refine (can be called from any thread)
+  if (! refinePending_.exchange(true))
+    QMetaObject::invokeMethod(this, "refineColumnTypes", Qt::QueuedConnection);
+}
+
+void
+CQBaseModel::
+refineColumnTypes()
+{
+  refinePending_ = false;
+
+  std::vector<int> columns;
+
+  {
+  ReadLock lock(mutex_);
+
+  for (const auto &columnData : columnDatas_) {
+    if (columnData->typeProvisional)
+      columns.push_back(columnData->column);
+  }
+  }
+
+  if (columns.empty())
+    return;
+
+  //---
+
+  if (isAsyncTypes()) {
+    // refine in background threads (limited to number of cores)
+    int maxThreads = std::max(int(std::thread::hardware_concurrency()), 1);
+
+    std::unique_lock<std::mutex> lock(refineMutex_);
+
+    // remove finished refines
+    auto pr = std::remove_if(refineDatas_.begin(), refineDatas_.end(),
+      [](const RefineData &refineData) {
+        return refineData.future.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+      });
+
+    refineDatas_.erase(pr, refineDatas_.end());
+
+    // remaining columns are launched when running refines finish
+    auto isRefining = [&](int column) {
+      for (const auto &refineData : refineDatas_) {
+        if (refineData.column == column && ! *refineData.cancel)
+          return true;
+      }
+
+      return false;
+    };
+
+    for (const auto &column : columns) {
+      if (int(refineDatas_.size()) >= maxThreads)
+        break;
+
+      if (isRefining(column))
+        continue;
+
+      launchRefineColumnType(column);
+    }
+
+    return;
+  }
+
+  //---
+
+  // refine one column per call so event loop can run between columns
+  refineColumnType(columns[0]);
+
+  if (columns.size() > 1)
+    scheduleRefineColumnTypes();
+}
+
+void
+CQBaseModel::
+launchRefineColumnType(int column)
+{
+  // called with refineMutex_ locked
+  RefineData refineData;
+
+  refineData.column = column;
+  refineData.cancel = std::make_shared<std::atomic<bool>>(false);
+
+  auto cancel = refineData.cancel;
+
+  refineData.future = std::async(std::launch::async, [this, column, cancel]() {
+    // check raw values of all rows (serial scan as already on worker thread)
+    CQModelUtil::ColumnTypeSample sample;
+
+    sample.type   = CQBaseModelTypeSample::FULL;
+    sample.role   = Qt::DisplayRole;
+    sample.cancel = cancel.get();
+    sample.serial = true;
+
+    bool complete;
+
+    auto type = CQModelUtil::calcColumnType(this, column, sample, &complete);
+
+    // cancelled refines are restarted by cancelRefineColumnType(s)
+    if (! complete || *cancel)
+      return;
+
+    // apply type on model's thread (unless cancelled by a later change of column
+    // data) and launch any remaining refines
+    QMetaObject::invokeMethod(this, [this, column, type, cancel]() {
+      if (! *cancel)
+        setRefinedColumnType(column, type);
+
+      scheduleRefineColumnTypes();
+    }, Qt::QueuedConnection);
+  });
+
+  refineDatas_.push_back(std::move(refineData));
+}
+
+void
+CQBaseModel::
+cancelRefineColumnTypes(bool restart)
+{
+  RefineDatas refineDatas;
+
+  {
+  std::unique_lock<std::mutex> lock(refineMutex_);
+
+  if (refineDatas_.empty())
+    return;
+
+  refineDatas.swap(refineDatas_);
   }
+
+  // stop running refines and wait for them to finish
+  for (auto &refineData : refineDatas)
+    *refineData.cancel = true;
+
+  for (auto &refineData : refineDatas)
+    refineData.future.wait();
+
+  // restart refine of still provisional columns
+  if (restart)
+    scheduleRefineColumnTypes();
+}
+
+void
+CQBaseModel::
+cancelRefineColumnType(int column)
+{
+  // only provisional columns are refined
+  if (! isColumnTypeProvisional(column))
+    return;
+
+  bool cancelled = false;
+
+  {
+  std::unique_lock<std::mutex> lock(refineMutex_);
+
+  // flag running refine of column (no wait, result is discarded when it finishes)
+  for (auto &refineData : refineDatas_) {
+    if (refineData.column == column && ! *refineData.cancel) {
+      *refineData.cancel = true;
+
+      cancelled = true;
+    }
+  }
+  }
+
+  // restart refine of column
+  if (cancelled)
+    scheduleRefineColumnTypes();
+}
+
+void
+CQBaseModel::
+refineColumnType(int column)
+{
+  if (! isColumnTypeProvisional(column))
+    return;
+
+  // check raw values of all rows
+  CQModelUtil::ColumnTypeSample sample;
+
+  sample.type = CQBaseModelTypeSample::FULL;
+  sample.role = Qt::DisplayRole;
+
+  auto type = CQModelUtil::calcColumnType(this, column, sample);
+
+  setRefinedColumnType(column, type);
+}
+
+void
+CQBaseModel::
+setRefinedColumnType(int column, CQBaseModelType type)
+{
+  if (column < 0 || column >= columnCount())
+    return;
+
+  auto &columnData = getColumnData(column);
+
+  bool changed = false;
+
+  {
+  std::unique_lock<std::mutex> lock(typeMutex_);
+
+  // type could have been assigned while refining
+  if (! columnData.typeProvisional)
+    return;
+
+  columnData.typeProvisional = false;
+
+  if (type != columnData.type) {
+    columnData.type     = type;
+    columnData.baseType = type;
+
+    changed = true;
+  }
+  }
+
+  if (changed)
+    Q_EMIT columnTypeChanged(column);
 }
 
 void
@@ -200,6 +480,10 @@ columnType(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  // no type (raw values) for thread calculating type
+  if (isTypeCalcThread(columnData))
+    return CQBaseModelType::NONE;
+
   if (columnData.type == CQBaseModelType::NONE)
     genColumnType(columnData);
 
@@ -218,6 +502,9 @@ setColumnType(int column, CQBaseModelType type)
   if (columnData.baseType == CQBaseModelType::NONE)
     genColumnType(columnData);
 
+  // assigned type is not refined
+  columnData.typeProvisional = false;
+
   if (type != columnData.type) {
     columnData.type = type;
 
@@ -227,6 +514,21 @@ setColumnType(int column, CQBaseModelType type)
   return true;
 }
 
+bool
+CQBaseModel::
+isColumnTypeProvisional(int column) const
+{
+  if (column < 0 || column >= columnCount())
+    return false;
+
+  const auto &columnData = getColumnData(column);
+
+  if (columnData.type == CQBaseModelType::NONE)
+    genColumnType(columnData);
+
+  return columnData.typeProvisional;
+}
+
 CQBaseModelType
 CQBaseModel::
 columnBaseType(int column) const
@@ -269,6 +571,8 @@ columnTypeValues(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.typeValues;
 }
 
@@ -281,7 +585,11 @@ setColumnTypeValues(int column, const QString &str)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.typeValues = str;
+  }
 
   Q_EMIT columnTypeChanged(column);
 
@@ -297,6 +605,8 @@ columnMin(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.min;
 }
 
@@ -309,7 +619,11 @@ setColumnMin(int column, const QVariant &v)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.min = v;
+  }
 
   Q_EMIT columnRangeChanged(column);
 
@@ -325,6 +639,8 @@ columnMax(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.max;
 }
 
@@ -337,7 +653,11 @@ setColumnMax(int column, const QVariant &v)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.max = v;
+  }
 
   Q_EMIT columnRangeChanged(column);
 
@@ -353,6 +673,8 @@ columnSum(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.sum;
 }
 
@@ -365,7 +687,11 @@ setColumnSum(int column, const QVariant &v)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.sum = v;
+  }
 
   Q_EMIT columnRangeChanged(column);
 
@@ -381,6 +707,8 @@ columnTarget(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.target;
 }
 
@@ -393,7 +721,11 @@ setColumnTarget(int column, const QVariant &v)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.target = v;
+  }
 
   Q_EMIT columnRangeChanged(column);
 
@@ -409,6 +741,8 @@ isColumnKey(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.key;
 }
 
@@ -421,13 +755,70 @@ setColumnKey(int column, bool b)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.key = b;
+  }
 
   Q_EMIT columnKeyChanged(column);
 
   return true;
 }
 
+int
+CQBaseModel::
+rowForKey(int column, const QVariant &value) const
+{
+  if (column < 0 || column >= columnCount())
+    return -1;
+
+  // match on variant key (same as key duplicates)
+  auto key = CQModelUtil::variantKey(value);
+
+  auto nr = rowCount();
+
+  for (decltype(nr) row = 0; row < nr; ++row) {
+    auto var = data(index(row, column, QModelIndex()), Qt::DisplayRole);
+
+    if (CQModelUtil::variantKey(var) == key)
+      return row;
+  }
+
+  return -1;
+}
+
+std::vector<int>
+CQBaseModel::
+keyDuplicates(int column) const
+{
+  std::vector<int> rows;
+
+  if (column < 0 || column >= columnCount())
+    return rows;
+
+  // match on variant key (type and value)
+  std::unordered_set<QString, VariantKeyHash> keys;
+
+  auto nr = rowCount();
+
+  for (decltype(nr) row = 0; row < nr; ++row) {
+    auto var = data(index(row, column, QModelIndex()), Qt::DisplayRole);
+
+    if (! keys.insert(CQModelUtil::variantKey(var)).second)
+      rows.push_back(row);
+  }
+
+  return rows;
+}
+
+bool
+CQBaseModel::
+hasKeyDuplicates(int column) const
+{
+  return ! keyDuplicates(column).empty();
+}
+
 bool
 CQBaseModel::
 isColumnSorted(int column) const
@@ -437,6 +828,8 @@ isColumnSorted(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.sorted;
 }
 
@@ -449,7 +842,11 @@ setColumnSorted(int column, bool b)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.sorted = b;
+  }
 
   Q_EMIT columnSortedChanged(column);
 
@@ -465,6 +862,8 @@ columnSortOrder(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.sortOrder;
 }
 
@@ -477,7 +876,11 @@ setColumnSortOrder(int column, Qt::SortOrder order)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.sortOrder = order;
+  }
 
   Q_EMIT columnSortOrderChanged(column);
 
@@ -493,6 +896,8 @@ columnTitle(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.title;
 }
 
@@ -505,7 +910,11 @@ setColumnTitle(int column, const QString &s)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.title = s;
+  }
 
   Q_EMIT columnTitleChanged(column);
 
@@ -521,6 +930,8 @@ columnTip(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.tip;
 }
 
@@ -533,7 +944,11 @@ setColumnTip(int column, const QString &s)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.tip = s;
+  }
 
   Q_EMIT columnTipChanged(column);
 
@@ -549,6 +964,8 @@ columnHeaderType(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.headerType;
 }
 
@@ -561,12 +978,21 @@ setColumnHeaderType(int column, CQBaseModelType type)
 
   auto &columnData = getColumnData(column);
 
+  bool changed = false;
+
+  {
+  WriteLock lock(mutex_);
+
   if (columnData.headerType != type) {
     columnData.headerType = type;
 
-    Q_EMIT columnHeaderTypeChanged(column);
+    changed = true;
+  }
   }
 
+  if (changed)
+    Q_EMIT columnHeaderTypeChanged(column);
+
   return true;
 }
 
@@ -579,6 +1005,8 @@ headerTypeValues(int column) const
 
   const auto &columnData = getColumnData(column);
 
+  ReadLock lock(mutex_);
+
   return columnData.headerTypeValues;
 }
 
@@ -591,7 +1019,11 @@ setHeaderTypeValues(int column, const QString &str)
 
   auto &columnData = getColumnData(column);
 
+  {
+  WriteLock lock(mutex_);
+
   columnData.headerTypeValues = str;
+  }
 
   Q_EMIT columnTypeChanged(column);
 
@@ -646,51 +1078,103 @@ CQBaseModel::ColumnData &
 CQBaseModel::
 getColumnData(int column)
 {
-  assert(column >= 0 || column < columnCount());
+  assert(column >= 0);
 
-  auto p = columnDatas_.find(column);
+  // lock free lookup in current table
+  const auto *columnTable = columnTable_.load(std::memory_order_acquire);
 
-  if (p != columnDatas_.end()) {
-    auto &columnData = (*p).second;
+  if (! columnTable || size_t(column) >= columnTable->size()) {
+    WriteLock lock(mutex_);
 
-    assert(columnData.column == column);
+    growColumnDatas(column);
 
-    return columnData;
+    columnTable = columnTable_.load(std::memory_order_acquire);
   }
 
-  //---
+  auto *columnData = (*columnTable)[size_t(column)];
+
+  assert(columnData->column == column);
+
+  return *columnData;
+}
+
+void
+CQBaseModel::
+growColumnDatas(int column)
+{
+  // called with mutex_ locked
+  auto nc = std::max(columnCount(), column + 1);
 
-  std::unique_lock<std::mutex> lock(mutex_);
+  if (int(columnDatas_.size()) >= nc)
+    return;
 
-  auto *th = const_cast<CQBaseModel *>(this);
+  for (auto c = int(columnDatas_.size()); c < nc; ++c)
+    columnDatas_.push_back(std::make_unique<ColumnData>(c));
 
-  auto p1 = th->columnDatas_.find(column);
+  updateColumnTable();
+}
+
+void
+CQBaseModel::
+updateColumnTable()
+{
+  // called with mutex_ locked. Publish new table (old table kept for current readers)
+  auto columnTable = std::make_unique<ColumnTable>();
 
-  if (p1 == th->columnDatas_.end())
-    p1 = th->columnDatas_.insert(p1, ColumnDatas::value_type(column, ColumnData(column)));
+  columnTable->reserve(columnDatas_.size());
 
-  return (*p1).second;
+  for (const auto &columnData : columnDatas_)
+    columnTable->push_back(columnData.get());
+
+  columnTable_.store(columnTable.get(), std::memory_order_release);
+
+  columnTables_.push_back(std::move(columnTable));
+}
+
+void
+CQBaseModel::
+releaseRetiredColumnDatas()
+{
+  WriteLock lock(mutex_);
+
+  retiredColumnDatas_.clear();
+
+  // keep current table only
+  const auto *columnTable = columnTable_.load(std::memory_order_acquire);
+
+  auto pt = std::remove_if(columnTables_.begin(), columnTables_.end(),
+    [&](const ColumnTableP &table) { return table.get() != columnTable; });
+
+  columnTables_.erase(pt, columnTables_.end());
 }
 
 void
 CQBaseModel::
 resetColumnType(int column)
 {
-  auto p = columnDatas_.find(column);
+  WriteLock lock(mutex_);
+
+  if (column < 0 || column >= int(columnDatas_.size()))
+    return;
+
+  // publish new column data (old one kept for current readers)
+  auto &columnData = columnDatas_[size_t(column)];
 
-  if (p != columnDatas_.end())
-    columnDatas_.erase(p);
+  retiredColumnDatas_.push_back(std::move(columnData));
+
+  columnData = std::make_unique<ColumnData>(column);
+
+  updateColumnTable();
 }
 
 void
 CQBaseModel::
 resetColumnTypes()
 {
-  for (auto &p : columnDatas_) {
-    auto &columnData = p.second;
+  WriteLock lock(mutex_);
 
-    columnData.type = CQBaseModelType::NONE;
-  }
+  for (auto &columnData : columnDatas_)
+    columnData->type = CQBaseModelType::NONE;
 }
 
 //------
@@ -702,6 +1186,8 @@ rowGroup(int row) const
   if (row < 0 || row >= rowCount())
     return QVariant();
 
+  ReadLock lock(mutex_);
+
   const RowData &rowData = getRowData(row);
 
   return rowData.group;
@@ -714,6 +1200,8 @@ setRowGroup(int row, const QVariant &v)
   if (row < 0 || row >= rowCount())
     return false;
 
+  WriteLock lock(mutex_);
+
   RowData &rowData = getRowData(row);
 
   rowData.group = v;
@@ -725,37 +1213,38 @@ const CQBaseModel::RowData &
 CQBaseModel::
 getRowData(int row) const
 {
-  return const_cast<CQBaseModel *>(this)->getRowData(row);
-}
+  // called with mutex_ locked (value must be copied before unlock)
+  assert(row >= 0);
 
-CQBaseModel::RowData &
-CQBaseModel::
-getRowData(int row)
-{
-  assert(row >= 0 || row < rowCount());
-
-  auto p = rowDatas_.find(row);
+  const auto &rowDatas = rowDatas_.get();
 
-  if (p != rowDatas_.end()) {
-    RowData &rowData = (*p).second;
+  auto p = rowDatas.find(row);
 
-    assert(rowData.row == row);
+  if (p == rowDatas.end()) {
+    // don't add row data for read
+    static RowData s_emptyRowData;
 
-    return rowData;
+    return s_emptyRowData;
   }
 
-  //---
+  return (*p).second;
+}
 
-  std::unique_lock<std::mutex> lock(mutex_);
+CQBaseModel::RowData &
+CQBaseModel::
+getRowData(int row)
+{
+  // called with mutex_ write locked
+  assert(row >= 0);
 
-  auto *th = const_cast<CQBaseModel *>(this);
+  auto &rowDatas = rowDatas_.modify();
 
-  auto p1 = th->rowDatas_.find(row);
+  auto p = rowDatas.find(row);
 
-  if (p1 == th->rowDatas_.end())
-    p1 = th->rowDatas_.insert(p1, RowDatas::value_type(row, RowData(row)));
+  if (p == rowDatas.end())
+    p = rowDatas.insert(p, RowDatas::value_type(row, RowData(row)));
 
-  return (*p1).second;
+  return (*p).second;
 }
 
 //------
@@ -764,8 +1253,12 @@ void
 CQBaseModel::
 beginResetModel()
 {
-  if (resetDepth_ == 0)
+  if (resetDepth_ == 0) {
+    // background type refines must not read model while it changes
+    cancelRefineColumnTypes();
+
     QAbstractItemModel::beginResetModel();
+  }
 
   ++resetDepth_;
 }
@@ -776,8 +1269,12 @@ endResetModel()
 {
   --resetDepth_;
 
-  if (resetDepth_ == 0)
+  if (resetDepth_ == 0) {
+    // no readers during reset so replaced column datas can be freed
+    releaseRetiredColumnDatas();
+
     QAbstractItemModel::endResetModel();
+  }
 }
 
 //------
@@ -1008,39 +1505,48 @@ data(const QModelIndex &index, int role) const
   return QVariant();
 }
 
+bool
+CQBaseModel::
+getRawColumnValues(int, int, int, std::vector<QVariant> &) const
+{
+  return false;
+}
+
 //------
 
 const CQBaseModel::RoleDatas &
 CQBaseModel::
 headerRoleDatas(Qt::Orientation orient) const
 {
-  static std::map<Qt::Orientation, CQBaseModel::RoleDatas> s_headerRoleDatas;
+  using HeaderRoleDatas = std::map<Qt::Orientation, CQBaseModel::RoleDatas>;
 
-  //---
+  // built once for both orientations (thread safe static init)
+  static HeaderRoleDatas s_headerRoleDatas = []() {
+    HeaderRoleDatas headerRoleDatas;
 
-  using Standard = CQBaseModel::Standard;
-  using Writable = CQBaseModel::Writable;
+    using Standard = CQBaseModel::Standard;
+    using Writable = CQBaseModel::Writable;
 
-  auto addHeaderRole = [&](Qt::Orientation orient, const QString &name, int role,
-                           const QVariant::Type &type, const Writable &writable) {
-    s_headerRoleDatas[orient].emplace_back(name, role, type, Standard(), writable);
-  };
+    auto addHeaderRole = [&](Qt::Orientation orient, const QString &name, int role,
+                             const QVariant::Type &type, const Writable &writable) {
+      headerRoleDatas[orient].emplace_back(name, role, type, Standard(), writable);
+    };
 
-  auto addHHeaderRole = [&](const QString &name, int role, const QVariant::Type &type,
-                            const Writable &writable=Writable()) {
-    addHeaderRole(Qt::Horizontal, name, role, type, writable);
-  };
+    auto addHHeaderRole = [&](const QString &name, int role, const QVariant::Type &type,
+                              const Writable &writable=Writable()) {
+      addHeaderRole(Qt::Horizontal, name, role, type, writable);
+    };
 
-  auto addVHeaderRole = [&](const QString &name, int role, const QVariant::Type &type,
-                            const Writable &writable=Writable()) {
-    addHeaderRole(Qt::Vertical, name, role, type, writable);
-  };
+    auto addVHeaderRole = [&](const QString &name, int role, const QVariant::Type &type,
+                              const Writable &writable=Writable()) {
+      addHeaderRole(Qt::Vertical, name, role, type, writable);
+    };
 
-  using CQModelUtil::roleCast;
+    using CQModelUtil::roleCast;
 
-  //---
+    //---
 
-  if      (orient == Qt::Horizontal) {
+    // horizontal
     addHHeaderRole("type"              , roleCast(CQBaseModelRole::Type),
                    QVariant::UserType, Writable(true));
     addHHeaderRole("base_type"         , roleCast(CQBaseModelRole::BaseType),
@@ -1073,13 +1579,23 @@ headerRoleDatas(Qt::Orientation orient) const
                    QVariant::UserType, Writable(true));
     addHHeaderRole("header_type_values", roleCast(CQBaseModelRole::HeaderTypeValues),
                    QVariant::Invalid , Writable(true));
-  }
-  else if (orient == Qt::Vertical) {
+
+    // vertical
     addVHeaderRole("group", roleCast(CQBaseModelRole::Group),
                    QVariant::Invalid, Writable(true));
+
+    return headerRoleDatas;
+  }();
+
+  auto p = s_headerRoleDatas.find(orient);
+
+  if (p == s_headerRoleDatas.end()) {
+    static CQBaseModel::RoleDatas s_emptyRoleDatas;
+
+    return s_emptyRoleDatas;
   }
 
-  return s_headerRoleDatas[orient];
+  return (*p).second;
 }
 
 const CQBaseModel::RoleDatas &
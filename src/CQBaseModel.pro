@@ -15,10 +15,13 @@ MOC_DIR = .moc
 SOURCES += \
 CQBaseModel.cpp \
 CQDataModel.cpp \
+CQDataModelStore.cpp \
 CQModelDetails.cpp \
+CQModelGroupBy.cpp \
 CQModelNameValues.cpp \
 CQModelUtil.cpp \
 CQModelVisitor.cpp \
+CQPivotModel.cpp \
 CQSortModel.cpp \
 CQValueSet.cpp \
 CQAlignVariant.cpp \
@@ -27,12 +30,16 @@ HEADERS += \
 ../include/CQBaseModel.h \
 ../include/CQBaseModelTypes.h \
 ../include/CQDataModel.h \
+../include/CQDataModelStore.h \
 ../include/CQModelDetails.h \
+../include/CQModelGroupBy.h \
 ../include/CQModelNameValues.h \
 ../include/CQModelUtil.h \
 ../include/CQModelVisitor.h \
+../include/CQPivotModel.h \
 ../include/CQSortModel.h \
 ../include/CQStatData.h \
+../include/CQValueIndex.h \
 ../include/CQValueSet.h \
 ../include/CQAlignVariant.h \
 
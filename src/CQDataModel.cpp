@@ -2,6 +2,7 @@
 #include <CQModelDetails.h>
 #include <CQModelUtil.h>
 #include <iostream>
+#include <algorithm>
 
 CQDataModel::
 CQDataModel(QObject *parent) :
@@ -27,7 +28,10 @@ CQDataModel(int numCols, int numRows) :
 CQDataModel::
 ~CQDataModel()
 {
-  delete details_;
+  // stop background type refines before data is destroyed
+  cancelRefineColumnTypes(/*restart*/false);
+
+  delete details_.load();
 }
 
 void
@@ -36,10 +40,28 @@ init(int numCols, int numRows)
 {
   setObjectName("dataModel");
 
-  if (numCols > 0 && numRows > 0)
+  // allow columns with no rows (rows added later)
+  if (numCols > 0 && numRows >= 0)
     init1(size_t(numCols), size_t(numRows));
 
   connect(this, SIGNAL(columnTypeChanged(int)), this, SLOT(resetColumnCache(int)));
+  connect(this, SIGNAL(columnKeyChanged(int)), this, SLOT(updateKeyColumn(int)));
+
+  // invalidate cached header values
+  connect(this, SIGNAL(columnTypeChanged(int)), this, SLOT(resetHeaderCache(int)));
+  connect(this, SIGNAL(columnBaseTypeChanged(int)), this, SLOT(resetHeaderCache(int)));
+  connect(this, SIGNAL(columnRangeChanged(int)), this, SLOT(resetHeaderCache(int)));
+  connect(this, SIGNAL(columnTitleChanged(int)), this, SLOT(resetHeaderCache(int)));
+  connect(this, SIGNAL(columnHeaderTypeChanged(int)), this, SLOT(resetHeaderCache(int)));
+  connect(this, SIGNAL(headerDataChanged(Qt::Orientation, int, int)),
+          this, SLOT(headerCacheChanged(Qt::Orientation, int, int)));
+  connect(this, SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)),
+          this, SLOT(dataCacheChanged(const QModelIndex &, const QModelIndex &)));
+  connect(this, SIGNAL(modelReset()), this, SLOT(resetHeaderCache()));
+  connect(this, SIGNAL(columnsInserted(const QModelIndex &, int, int)),
+          this, SLOT(resetHeaderCache()));
+  connect(this, SIGNAL(columnsRemoved(const QModelIndex &, int, int)),
+          this, SLOT(resetHeaderCache()));
 }
 
 void
@@ -49,10 +71,14 @@ init1(size_t numCols, size_t numRows)
   hheader_.resize(numCols);
   vheader_.resize(numRows);
 
-  data_.resize(numRows);
+  columnMap_.clear();
+
+  resetHeaderCache();
+
+  data_.clear();
 
   for (size_t i = 0; i < numRows; ++i)
-    data_[i].resize(numCols);
+    data_.push_back(Cells(numCols));
 
   clearCachedColumn();
 }
@@ -63,18 +89,54 @@ copyModel(CQDataModel *model)
 {
   beginResetModel();
 
-  // copy data
-  hheader_ = model->hheader_;
-  vheader_ = model->vheader_;
-  data_    = model->data_;
+  // copy data (row storage shared copy on write)
+  {
+  ReadLock  modelLock(model->mutex_);
+  WriteLock lock(mutex_);
+
+  hheader_   = model->hheader_;
+  vheader_   = model->vheader_;
+  data_      = model->data_;
+  columnMap_ = model->columnMap_;
+  }
 
   CQBaseModel::copyModel(model);
 
   clearCachedColumn();
 
+  auto nc = columnCount();
+
+  for (decltype(nc) c = 0; c < nc; ++c)
+    updateKeyColumn(c);
+
   endResetModel();
 }
 
+CQDataModel::Snapshot
+CQDataModel::
+snapshot() const
+{
+  // lock so edits (which take write lock) see storage as shared
+  ReadLock lock(mutex_);
+
+  Snapshot snapshot;
+
+  snapshot.hheader_   = hheader_;
+  snapshot.columnMap_ = columnMap_;
+  snapshot.data_      = data_;
+
+  return snapshot;
+}
+
+size_t
+CQDataModel::
+dataVersion() const
+{
+  ReadLock lock(mutex_);
+
+  return data_.version();
+}
+
 void
 CQDataModel::
 resizeModel(int numCols, int numRows)
@@ -91,22 +153,37 @@ void
 CQDataModel::
 addRow(int n)
 {
-  beginResetModel();
+  if (n <= 0)
+    return;
 
-  if (! vheader_.empty())
-    vheader_.push_back("");
+  cancelRefineColumnTypes();
+
+  auto nr = rowCount();
+
+  beginInsertRows(QModelIndex(), nr, nr + n - 1);
+
+  {
+  WriteLock lock(mutex_);
 
   for (int i = 0; i < n; ++i) {
+    if (! vheader_.empty())
+      vheader_.push_back("");
+
     Cells row;
 
-    row.resize(size_t(columnCount()));
+    row.resize(hheader_.size());
 
     data_.push_back(row);
   }
 
-  clearCachedColumn();
+  // extend built column indices with new rows (no rebuild)
+  addColumnIndexRows(nr, n);
+  }
 
-  endResetModel();
+  cachedColumn_ = -1;
+  cachedColumnVars_.clear();
+
+  endInsertRows();
 }
 
 void
@@ -115,16 +192,23 @@ addColumn(int n)
 {
   beginResetModel();
 
-  auto nr = rowCount();
+  {
+  WriteLock lock(mutex_);
+
+  auto nr = data_.size();
 
   hheader_.push_back("");
 
-  for (size_t ir = 0; ir < size_t(nr); ++ir) {
-    auto &row = data_[ir];
+  if (! columnMap_.empty())
+    columnMap_.push_back(int(hheader_.size()) - 1);
+
+  for (size_t ir = 0; ir < nr; ++ir) {
+    auto &row = data_.modifyRow(ir);
 
     for (int i = 0; i < n; ++i)
       row.push_back("");
   }
+  }
 
   clearCachedColumn();
 
@@ -137,17 +221,21 @@ void
 CQDataModel::
 initFilter()
 {
-  setFilterInited(true);
-
-  //---
+  // build filter datas before publishing (readers skip init once inited is set)
+  FilterDatas filterDatas;
 
-  filterDatas_.clear();
+  if (hasFilter())
+    buildFilterDatas(filterDatas);
 
-  if (! hasFilter())
-    return;
+  filterDatas_.swap(filterDatas);
 
-  //---
+  setFilterInited(true);
+}
 
+void
+CQDataModel::
+buildFilterDatas(FilterDatas &filterDatas) const
+{
   auto numHeaders = hheader_.size();
 
   auto patterns = filter_.split(",");
@@ -188,7 +276,7 @@ initFilter()
 
     filterData.valid = (filterData.column >= 0 && filterData.column < int(numHeaders));
 
-    filterDatas_.push_back(filterData);
+    filterDatas.push_back(filterData);
   }
 }
 
@@ -202,7 +290,7 @@ acceptsRow(const Cells &cells) const
   //---
 
   if (! isFilterInited()) {
-    std::unique_lock<std::mutex> lock(mutex_);
+    WriteLock lock(mutex_);
 
     if (! isFilterInited()) {
       auto *th = const_cast<CQDataModel *>(this);
@@ -234,6 +322,9 @@ int
 CQDataModel::
 columnCount(const QModelIndex &) const
 {
+  if (! columnMap_.empty())
+    return int(columnMap_.size());
+
   return int(hheader_.size());
 }
 
@@ -265,40 +356,23 @@ headerData(int section, Qt::Orientation orientation, int role) const
     if (section < 0 || section >= numCols)
       return QVariant();
 
-    if      (role == Qt::DisplayRole) {
-      if (hheader_[section1].toString().length())
-        return hheader_[section1];
-
-      return CQBaseModel::headerData(section, orientation, role);
-    }
-    else if (role == Qt::EditRole) {
-      if (hheader_[section1].toString().length())
-        return hheader_[section1];
-
-      return CQBaseModel::headerData(section, orientation, role);
-    }
-    else if (role == Qt::ToolTipRole) {
-      auto var = hheader_[section1];
+    // calculated roles are cached (invalidated by column and header changes)
+    if (role == Qt::DisplayRole || role == Qt::EditRole || role == Qt::ToolTipRole ||
+        role == static_cast<int>(CQBaseModelRole::DataMin) ||
+        role == static_cast<int>(CQBaseModelRole::DataMax)) {
+      QVariant var;
 
-      auto type = columnType(section);
+      if (getHeaderCache(section, role, var))
+        return var;
 
-      auto str = var.toString() + ":" + typeName(type);
+      var = calcHeaderData(section, role);
 
-      return QVariant(str);
-    }
-    else if (role == static_cast<int>(CQBaseModelRole::DataMin)) {
-      auto *details = getDetails();
+      setHeaderCache(section, role, var);
 
-      return details->columnDetails(section)->minValue();
+      return var;
     }
-    else if (role == static_cast<int>(CQBaseModelRole::DataMax)) {
-      auto *details = getDetails();
 
-      return details->columnDetails(section)->maxValue();
-    }
-    else {
-      return CQBaseModel::headerData(section, orientation, role);
-    }
+    return CQBaseModel::headerData(section, orientation, role);
   }
   else {
     if (vheader_.empty())
@@ -330,6 +404,118 @@ headerData(int section, Qt::Orientation orientation, int role) const
   }
 }
 
+QVariant
+CQDataModel::
+calcHeaderData(int section, int role) const
+{
+  auto hsection = size_t(dataColumn(section));
+
+  if      (role == Qt::DisplayRole) {
+    if (hheader_[hsection].toString().length())
+      return hheader_[hsection];
+
+    return CQBaseModel::headerData(section, Qt::Horizontal, role);
+  }
+  else if (role == Qt::EditRole) {
+    if (hheader_[hsection].toString().length())
+      return hheader_[hsection];
+
+    return CQBaseModel::headerData(section, Qt::Horizontal, role);
+  }
+  else if (role == Qt::ToolTipRole) {
+    auto var = hheader_[hsection];
+
+    auto type = columnType(section);
+
+    auto str = var.toString() + ":" + typeName(type);
+
+    return QVariant(str);
+  }
+  else if (role == static_cast<int>(CQBaseModelRole::DataMin)) {
+    auto *details = getDetails();
+
+    return details->columnDetails(section)->minValue();
+  }
+  else if (role == static_cast<int>(CQBaseModelRole::DataMax)) {
+    auto *details = getDetails();
+
+    return details->columnDetails(section)->maxValue();
+  }
+  else {
+    return CQBaseModel::headerData(section, Qt::Horizontal, role);
+  }
+}
+
+bool
+CQDataModel::
+getHeaderCache(int section, int role, QVariant &value) const
+{
+  ReadLock lock(mutex_);
+
+  if (size_t(section) >= headerCache_.size())
+    return false;
+
+  const auto &roleValues = headerCache_[size_t(section)];
+
+  auto p = roleValues.find(role);
+  if (p == roleValues.end()) return false;
+
+  value = (*p).second;
+
+  return true;
+}
+
+void
+CQDataModel::
+setHeaderCache(int section, int role, const QVariant &value) const
+{
+  WriteLock lock(mutex_);
+
+  if (size_t(section) >= headerCache_.size())
+    headerCache_.resize(size_t(section + 1));
+
+  headerCache_[size_t(section)][role] = value;
+}
+
+void
+CQDataModel::
+resetHeaderCache(int column)
+{
+  WriteLock lock(mutex_);
+
+  if (column >= 0 && size_t(column) < headerCache_.size())
+    headerCache_[size_t(column)].clear();
+}
+
+void
+CQDataModel::
+resetHeaderCache()
+{
+  WriteLock lock(mutex_);
+
+  headerCache_.clear();
+}
+
+void
+CQDataModel::
+headerCacheChanged(Qt::Orientation orient, int first, int last)
+{
+  if (orient != Qt::Horizontal)
+    return;
+
+  for (int c = first; c <= last; ++c)
+    resetHeaderCache(c);
+}
+
+void
+CQDataModel::
+dataCacheChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+  // data min/max of changed columns
+  for (int c = topLeft.column(); c <= bottomRight.column(); ++c)
+    resetHeaderCache(c);
+}
+
 bool
 CQDataModel::
 setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role)
@@ -349,7 +535,7 @@ setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, i
       return false;
 
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
-      hheader_[section1] = value;
+      hheader_[size_t(dataColumn(section))] = value;
 
       Q_EMIT headerDataChanged(orientation, section, section);
 
@@ -391,18 +577,28 @@ data(const QModelIndex &index, int role) const
   int r = index.row();
   int c = index.column();
 
-  auto nr = data_.size();
+  if (c < 0 || c >= columnCount())
+    return QVariant();
 
-  if (r < 0 || size_t(r) >= nr)
+  // copy cell value with read lock (cells are modified with write lock)
+  QVariant cell;
+
+  {
+  ReadLock lock(mutex_);
+
+  if (r < 0 || size_t(r) >= data_.size())
     return QVariant();
 
   const auto &cells = data_[size_t(r)];
 
-  auto nc = cells.size();
+  auto dc = size_t(dataColumn(c));
 
-  if (c < 0 || size_t(c) >= nc)
+  if (dc >= cells.size())
     return QVariant();
 
+  cell = cells[dc];
+  }
+
   //---
 
   const auto &columnData = getColumnData(c);
@@ -410,10 +606,12 @@ data(const QModelIndex &index, int role) const
   //---
 
   auto getRowRoleValue = [&](int row, int role, QVariant &value) {
-    std::unique_lock<std::mutex> lock(mutex_);
+    ReadLock lock(mutex_);
 
-    auto pr = columnData.roleRowValues.find(role);
-    if (pr == columnData.roleRowValues.end()) return false;
+    const auto &roleRowValues = columnData.roleRowValues.get();
+
+    auto pr = roleRowValues.find(role);
+    if (pr == roleRowValues.end()) return false;
 
     const RowValues &rowValues = (*pr).second;
 
@@ -426,11 +624,11 @@ data(const QModelIndex &index, int role) const
   };
 
   auto setRowRoleValue = [&](int row, int role, const QVariant &value) {
-    std::unique_lock<std::mutex> lock(mutex_);
+    WriteLock lock(mutex_);
 
     auto &columnData1 = const_cast<ColumnData &>(columnData);
 
-    columnData1.roleRowValues[role][row] = value;
+    columnData1.roleRowValues.modify()[role][row] = value;
   };
 
   using CQModelUtil::roleCast;
@@ -438,9 +636,10 @@ data(const QModelIndex &index, int role) const
   //---
 
   if      (role == Qt::DisplayRole) {
-    return cells[size_t(c)];
+    return cell;
   }
   else if (role == Qt::EditRole) {
+    // type is NONE (raw value) if read while this thread calculates column type
     auto type = columnType(c);
 
     // check in cached values
@@ -452,7 +651,7 @@ data(const QModelIndex &index, int role) const
     }
 
     // not cached so get raw value
-    var = cells[size_t(c)];
+    var = cell;
 
     // column has no type or already correct type then just return
     if (type == CQBaseModelType::NONE || isSameType(var, type))
@@ -471,7 +670,7 @@ data(const QModelIndex &index, int role) const
     return var;
   }
   else if (role == Qt::ToolTipRole) {
-    return cells[size_t(c)];
+    return cell;
   }
   else if (role == roleCast(CQBaseModelRole::RawValue) ||
            role == roleCast(CQBaseModelRole::IntermediateValue) ||
@@ -483,7 +682,7 @@ data(const QModelIndex &index, int role) const
       return var;
 
     if (role == roleCast(CQBaseModelRole::RawValue)) {
-      return cells[size_t(c)];
+      return cell;
     }
 
     return QVariant();
@@ -521,6 +720,12 @@ setData(const QModelIndex &index, const QVariant &value, int role)
   if (changed)
     Q_EMIT dataChanged(index, index, QVector<int>(1, role));
 
+  // check for duplicate key (hash probe)
+  if ((role == Qt::DisplayRole || role == Qt::EditRole) && isColumnKey(c)) {
+    if (findColumnValues(c, value).size() > 1)
+      Q_EMIT columnKeyDuplicate(c, r);
+  }
+
   return true;
 }
 
@@ -536,17 +741,13 @@ setModelData(int r, int c, const QVariant &value, int role, bool *changed)
   if (r < 0 || size_t(r) >= nr)
     return false;
 
-  auto &cells = data_[size_t(r)];
-
-//auto nc = cells.size();
   auto nc = columnCount();
 
   if (c < 0 || c >= nc)
     return false;
 
-  //---
-
-  clearCachedColumn();
+  // background type refine of column is out of date after change
+  cancelRefineColumnType(c);
 
   //---
 
@@ -555,43 +756,73 @@ setModelData(int r, int c, const QVariant &value, int role, bool *changed)
   //---
 
   auto clearRowRoleValue = [&](int row, int role) {
-    std::unique_lock<std::mutex> lock(mutex_);
+    WriteLock lock(mutex_);
 
-    auto pr = columnData.roleRowValues.find(role);
-    if (pr == columnData.roleRowValues.end()) return false;
+    // check before modify so shared values are only copied if changed
+    const auto &roleRowValues = columnData.roleRowValues.get();
 
-    RowValues &rowValues = (*pr).second;
+    auto pr = roleRowValues.find(role);
+    if (pr == roleRowValues.end()) return false;
 
-    auto pr1 = rowValues.find(row);
-    if (pr1 == rowValues.end()) return false;
+    if ((*pr).second.find(row) == (*pr).second.end()) return false;
 
-    rowValues.erase(pr1);
+    columnData.roleRowValues.modify()[role].erase(row);
 
     return true;
   };
 
   auto setRowRoleValue = [&](int row, int role, const QVariant &value) {
-    std::unique_lock<std::mutex> lock(mutex_);
+    WriteLock lock(mutex_);
 
-    columnData.roleRowValues[role][row] = value;
+    columnData.roleRowValues.modify()[role][row] = value;
   };
 
   using CQModelUtil::roleCast;
 
   //---
 
+  // set cell value (copies row chunk if shared with snapshot)
+  auto setCellValue = [&](QVariant &oldValue) {
+    WriteLock lock(mutex_);
+
+    auto &cells = data_.modifyRow(size_t(r));
+
+    auto dc = size_t(dataColumn(c));
+
+    while (dc >= cells.size())
+      cells.push_back(QVariant());
+
+    oldValue = cells[dc];
+
+    cells[dc] = value;
+  };
+
+  auto updateCachedColumn = [&](const QVariant &oldValue) {
+    if (c == cachedColumn_ && r < cachedColumnVars_.size())
+      cachedColumnVars_[r] = value;
+
+    updateColumnIndex(r, c, oldValue, value);
+  };
+
+  //---
+
   if      (role == Qt::DisplayRole) {
     //auto type = columnType(c);
 
-    cells[size_t(c)] = value;
+    QVariant oldValue;
+
+    setCellValue(oldValue);
+
+    updateCachedColumn(oldValue);
   }
   else if (role == Qt::EditRole) {
     //auto type = columnType(c);
 
-    while (size_t(c) >= cells.size())
-      cells.push_back(QVariant());
+    QVariant oldValue;
 
-    cells[size_t(c)] = value;
+    setCellValue(oldValue);
+
+    updateCachedColumn(oldValue);
 
     clearRowRoleValue(r, roleCast(CQBaseModelRole::RawValue));
     clearRowRoleValue(r, roleCast(CQBaseModelRole::IntermediateValue));
@@ -620,36 +851,63 @@ const CQBaseModel::RoleDatas &
 CQDataModel::
 roleDatas() const
 {
-  static RoleDatas s_roleDatas;
+  // built once (thread safe static init)
+  static RoleDatas s_roleDatas = []() {
+    RoleDatas roleDatas;
 
-  //---
+    using Standard = CQBaseModel::Standard;
+    using Writable = CQBaseModel::Writable;
 
-  using Standard = CQBaseModel::Standard;
-  using Writable = CQBaseModel::Writable;
+    auto addRole = [&](const QString &name, int role, const QVariant::Type &type,
+                       const Writable &writable=Writable()) {
+      roleDatas.emplace_back(name, role, type, Standard(), writable);
+    };
 
-  auto addRole = [&](const QString &name, int role, const QVariant::Type &type,
-                     const Writable &writable=Writable()) {
-    s_roleDatas.emplace_back(name, role, type, Standard(), writable);
-  };
+    using CQModelUtil::roleCast;
 
-  using CQModelUtil::roleCast;
+    //---
 
-  //---
+    addRole("raw_value"         , roleCast(CQBaseModelRole::RawValue         ),
+            QVariant::Invalid, Writable());
+    addRole("intermediate_value", roleCast(CQBaseModelRole::IntermediateValue),
+            QVariant::Invalid, Writable());
+    addRole("cached_value"      , roleCast(CQBaseModelRole::CachedValue      ),
+            QVariant::Invalid, Writable());
+    addRole("output_value"      , roleCast(CQBaseModelRole::OutputValue      ),
+            QVariant::Invalid, Writable());
 
-  addRole("raw_value"         , roleCast(CQBaseModelRole::RawValue         ),
-          QVariant::Invalid, Writable());
-  addRole("intermediate_value", roleCast(CQBaseModelRole::IntermediateValue),
-          QVariant::Invalid, Writable());
-  addRole("cached_value"      , roleCast(CQBaseModelRole::CachedValue      ),
-          QVariant::Invalid, Writable());
-  addRole("output_value"      , roleCast(CQBaseModelRole::OutputValue      ),
-          QVariant::Invalid, Writable());
+    return roleDatas;
+  }();
 
   return s_roleDatas;
 }
 
 //------
 
+bool
+CQDataModel::
+getRawColumnValues(int column, int row, int n, std::vector<QVariant> &values) const
+{
+  ReadLock lock(mutex_);
+
+  auto nr = int(data_.size());
+
+  if (column < 0 || column >= columnCount() || row < 0 || n < 0 || row + n > nr)
+    return false;
+
+  auto dc = size_t(dataColumn(column));
+
+  values.resize(size_t(n));
+
+  for (int i = 0; i < n; ++i) {
+    const auto &cells = data_[size_t(row + i)];
+
+    values[size_t(i)] = (dc < cells.size() ? cells[dc] : QVariant());
+  }
+
+  return true;
+}
+
 QModelIndex
 CQDataModel::
 index(int row, int column, const QModelIndex &) const
@@ -686,10 +944,11 @@ void
 CQDataModel::
 resetColumnCache(int column)
 {
-  std::unique_lock<std::mutex> lock(mutex_);
-
+  // get column data before lock (locks if column data added)
   auto &columnData = getColumnData(column);
 
+  WriteLock lock(mutex_);
+
   columnData.roleRowValues.clear();
 }
 
@@ -697,17 +956,23 @@ CQModelDetails *
 CQDataModel::
 getDetails() const
 {
-  if (! details_) {
-    std::unique_lock<std::mutex> lock(mutex_);
+  auto *details = details_.load(std::memory_order_acquire);
+
+  if (! details) {
+    WriteLock lock(mutex_);
 
-    if (! details_) {
+    details = details_.load(std::memory_order_acquire);
+
+    if (! details) {
       auto *th = const_cast<CQDataModel *>(this);
 
-      th->details_ = new CQModelDetails(th);
+      details = new CQModelDetails(th);
+
+      th->details_.store(details, std::memory_order_release);
     }
   }
 
-  return details_;
+  return details;
 }
 
 //------
@@ -719,26 +984,18 @@ applyFilterColumns(const QStringList &columns)
   if (! columns.length())
     return;
 
-  auto data    = data_;
-  auto hheader = hheader_;
-
-  std::map<int, int> columnMap;
-
-  int nc1 = int(hheader_.size());
-  int nc2 = columns.length();
+  // get data column for each matching column name (data is not copied)
+  Columns columnMap;
 
-  for (int c = 0; c < nc1; ++c)
-    columnMap[c] = -1;
-
-  for (int c = 0; c < nc2; ++c) {
-    const auto &name = columns[c];
+  int nc = columnCount();
 
+  for (const auto &name : columns) {
     // get index for matching column name
     int ind = -1;
 
-    for (int c1 = 0; c1 < nc1; ++c1) {
-      if (hheader[size_t(c1)] == name) {
-        ind = c1;
+    for (int c = 0; c < nc; ++c) {
+      if (hheader_[size_t(dataColumn(c))] == name) {
+        ind = c;
         break;
       }
     }
@@ -749,7 +1006,7 @@ applyFilterColumns(const QStringList &columns)
 
       int ind1 = name.toInt(&ok);
 
-      if (ok && ind1 >= 0 && ind1 < nc1)
+      if (ok && ind1 >= 0 && ind1 < nc)
         ind = ind1;
     }
 
@@ -758,48 +1015,235 @@ applyFilterColumns(const QStringList &columns)
       continue;
     }
 
-    columnMap[ind] = c;
+    columnMap.push_back(dataColumn(ind));
+  }
+
+  setColumnMap(columnMap);
+}
+
+void
+CQDataModel::
+setColumnMap(const Columns &columns)
+{
+  auto nc = int(hheader_.size());
+
+  for (const auto &c : columns) {
+    if (c < 0 || c >= nc) {
+      std::cerr << "Invalid data column " << c << "\n";
+      return;
+    }
   }
 
-  // get new number of columns
-  nc2 = 0;
+  //---
+
+  beginResetModel();
 
-  for (int c = 0; c < nc1; ++c) {
-    int c1 = columnMap[c];
+  int nc1 = columnCount(), nc2 = 0;
 
-    if (c1 >= 0 && c1 < nc1)
-      ++nc2;
+  {
+  WriteLock lock(mutex_);
+
+  // column data of old columns by data column
+  std::map<int, ColumnDataP> dataColumnDatas;
+
+  for (auto &columnData : columnDatas_) {
+    if (columnData->column < nc1)
+      dataColumnDatas[dataColumn(columnData->column)] = std::move(columnData);
   }
 
-  // remap horizontal header and row data
-  hheader_.clear(); hheader_.resize(size_t(nc2));
+  columnMap_ = columns;
+
+  // move column datas (type, key, title, cached values, ...) to new column of same
+  // data column (copy if data column used again) or add new column data
+  nc2 = columnCount();
 
-  auto nr = data.size();
+  ColumnDatas columnDatas;
 
-  for (size_t r = 0; r < nr; ++r) {
-    auto &cells1 = data [r]; // old data
-    auto &cells2 = data_[r]; // new data
+  std::map<int, const ColumnData *> usedColumnDatas;
 
-    cells2.clear(); cells2.resize(size_t(nc2));
+  for (int c = 0; c < nc2; ++c) {
+    auto dc = dataColumn(c);
 
-    for (int c = 0; c < nc1; ++c) {
-      int c1 = columnMap[c];
+    auto pu = usedColumnDatas.find(dc);
+    auto pd = dataColumnDatas.find(dc);
 
-      if (c1 < 0 || c1 >= nc1)
-        continue;
+    if      (pu != usedColumnDatas.end())
+      columnDatas.push_back(std::make_unique<ColumnData>(*(*pu).second));
+    else if (pd != dataColumnDatas.end())
+      columnDatas.push_back(std::move((*pd).second));
+    else
+      columnDatas.push_back(std::make_unique<ColumnData>(c));
 
-      hheader_[size_t(c1)] = hheader[size_t(c)];
-      cells2  [size_t(c1)] = cells1 [size_t(c)];
-    }
+    columnDatas.back()->column = c;
+
+    usedColumnDatas[dc] = columnDatas.back().get();
+  }
+
+  // column datas of dropped data columns are freed at end of reset
+  for (auto &pd : dataColumnDatas) {
+    if (pd.second)
+      retiredColumnDatas_.push_back(std::move(pd.second));
+  }
+
+  columnDatas_ = std::move(columnDatas);
+
+  updateColumnTable();
   }
+
+  resetHeaderCache();
+
+  // cached column values and key indices are for old columns (cached role values
+  // move with column data of data column)
+  clearCachedColumn();
+
+  for (int c = 0; c < std::max(nc1, nc2); ++c)
+    updateKeyColumn(c);
+
+  endResetModel();
 }
 
 //---
 
+bool
+CQDataModel::
+isColumnIndexed(int column) const
+{
+  ReadLock lock(mutex_);
+
+  return (columnIndices_.find(column) != columnIndices_.end());
+}
+
+void
+CQDataModel::
+setColumnIndexed(int column, bool b)
+{
+  WriteLock lock(mutex_);
+
+  // index built on first lookup
+  auto &columnIndex = columnIndices_[column];
+
+  columnIndex.indexed = b;
+
+  // key columns keep index
+  if (! columnIndex.indexed && ! columnIndex.key)
+    columnIndices_.erase(column);
+}
+
+void
+CQDataModel::
+updateKeyColumn(int column)
+{
+  bool key = isColumnKey(column);
+
+  WriteLock lock(mutex_);
+
+  if (key) {
+    columnIndices_[column].key = true;
+  }
+  else {
+    auto p = columnIndices_.find(column);
+
+    if (p != columnIndices_.end()) {
+      (*p).second.key = false;
+
+      if (! (*p).second.indexed)
+        columnIndices_.erase(p);
+    }
+  }
+}
+
+int
+CQDataModel::
+rowForKey(int column, const QVariant &value) const
+{
+  if (isColumnKey(column))
+    return findColumnValue(column, value);
+
+  return CQBaseModel::rowForKey(column, value);
+}
+
+std::vector<int>
+CQDataModel::
+keyDuplicates(int column) const
+{
+  if (! isColumnKey(column))
+    return CQBaseModel::keyDuplicates(column);
+
+  std::vector<int> rows;
+
+  ReadLock lock;
+
+  const auto *columnIndex = readColumnIndex(column, lock);
+  if (! columnIndex || columnIndex->numDuplicates == 0) return rows;
+
+  // all rows after first for values with multiple rows
+  for (const auto &pv : columnIndex->valueRows) {
+    const auto &valueRows = pv.second;
+
+    for (size_t i = 1; i < valueRows.size(); ++i)
+      rows.push_back(valueRows[i]);
+  }
+
+  std::sort(rows.begin(), rows.end());
+
+  return rows;
+}
+
+bool
+CQDataModel::
+hasKeyDuplicates(int column) const
+{
+  if (! isColumnKey(column))
+    return CQBaseModel::hasKeyDuplicates(column);
+
+  ReadLock lock;
+
+  const auto *columnIndex = readColumnIndex(column, lock);
+
+  return (columnIndex && columnIndex->numDuplicates > 0);
+}
+
 int
 CQDataModel::
 findColumnValue(int column, const QVariant &var) const
 {
+  {
+  ReadLock lock;
+
+  const auto *columnIndex = readColumnIndex(column, lock);
+
+  if (columnIndex) {
+    auto dc = size_t(dataColumn(column));
+
+    // index is by value key so check candidate rows of each probe key with same
+    // (QVariant ==) rule as non-indexed search
+    int row = -1;
+
+    for (const auto &key : columnIndexKeys(var)) {
+      auto p = columnIndex->valueRows.find(key);
+
+      if (p == columnIndex->valueRows.end())
+        continue;
+
+      for (const auto &r : (*p).second) {
+        if (row >= 0 && r >= row)
+          break;
+
+        const auto &cells = data_[size_t(r)];
+
+        if (dc < cells.size() && cells[dc] == var) {
+          row = r;
+          break;
+        }
+      }
+    }
+
+    return row;
+  }
+  }
+
+  //---
+
   updateColumnValues(column);
 
   int nr = cachedColumnVars_.size();
@@ -812,6 +1256,55 @@ findColumnValue(int column, const QVariant &var) const
   return -1;
 }
 
+std::vector<int>
+CQDataModel::
+findColumnValues(int column, const QVariant &var) const
+{
+  std::vector<int> rows;
+
+  {
+  ReadLock lock;
+
+  const auto *columnIndex = readColumnIndex(column, lock);
+
+  if (columnIndex) {
+    auto dc = size_t(dataColumn(column));
+
+    for (const auto &key : columnIndexKeys(var)) {
+      auto p = columnIndex->valueRows.find(key);
+
+      if (p == columnIndex->valueRows.end())
+        continue;
+
+      for (const auto &r : (*p).second) {
+        const auto &cells = data_[size_t(r)];
+
+        if (dc < cells.size() && cells[dc] == var)
+          rows.push_back(r);
+      }
+    }
+
+    // row lists of each key are sorted (and distinct) so merge to row order
+    std::sort(rows.begin(), rows.end());
+
+    return rows;
+  }
+  }
+
+  //---
+
+  updateColumnValues(column);
+
+  int nr = cachedColumnVars_.size();
+
+  for (int r = 0; r < nr; ++r) {
+    if (cachedColumnVars_[r] == var)
+      rows.push_back(r);
+  }
+
+  return rows;
+}
+
 void
 CQDataModel::
 getColumnValues(int column, QVariantList &vars) const
@@ -848,4 +1341,249 @@ clearCachedColumn()
 {
   cachedColumn_ = -1;
   cachedColumnVars_.clear();
+
+  invalidateColumnIndices();
+}
+
+//---
+
+// get column index (if enabled), building if needed. Called with mutex write locked.
+CQDataModel::ColumnIndex *
+CQDataModel::
+getColumnIndex(int column) const
+{
+  auto p = columnIndices_.find(column);
+
+  if (p == columnIndices_.end())
+    return nullptr;
+
+  auto &columnIndex = (*p).second;
+
+  if (! columnIndex.valid) {
+    columnIndex.valueRows.clear();
+
+    auto dc = size_t(dataColumn(column));
+
+    // rows added in increasing order so row lists are sorted
+    auto nr = data_.size();
+
+    for (size_t r = 0; r < nr; ++r) {
+      const auto &cells = data_[r];
+
+      auto var = (dc < cells.size() ? cells[dc] : QVariant());
+
+      columnIndex.valueRows[columnIndexKey(var)].push_back(int(r));
+    }
+
+    columnIndex.numDuplicates = 0;
+
+    for (const auto &pv : columnIndex.valueRows) {
+      if (pv.second.size() > 1)
+        ++columnIndex.numDuplicates;
+    }
+
+    columnIndex.valid = true;
+  }
+
+  return &columnIndex;
+}
+
+// get built column index (if enabled) with mutex read locked. Index is built with
+// write lock (if needed) and returned with read lock held by lock.
+const CQDataModel::ColumnIndex *
+CQDataModel::
+readColumnIndex(int column, ReadLock &lock) const
+{
+  lock = ReadLock(mutex_);
+
+  while (true) {
+    auto p = columnIndices_.find(column);
+
+    if (p == columnIndices_.end())
+      return nullptr;
+
+    if ((*p).second.valid)
+      return &(*p).second;
+
+    // build index (could be invalidated again before read lock reacquired)
+    lock.unlock();
+
+    {
+    WriteLock wlock(mutex_);
+
+    (void) getColumnIndex(column);
+    }
+
+    lock.lock();
+  }
+}
+
+void
+CQDataModel::
+updateColumnIndex(int row, int column, const QVariant &oldValue, const QVariant &newValue)
+{
+  WriteLock lock(mutex_);
+
+  auto p = columnIndices_.find(column);
+
+  if (p == columnIndices_.end())
+    return;
+
+  auto &columnIndex = (*p).second;
+
+  // not built yet so nothing to update
+  if (! columnIndex.valid)
+    return;
+
+  auto oldKey = columnIndexKey(oldValue);
+  auto newKey = columnIndexKey(newValue);
+
+  if (oldKey == newKey)
+    return;
+
+  // remove row from old value rows
+  auto po = columnIndex.valueRows.find(oldKey);
+
+  if (po != columnIndex.valueRows.end()) {
+    auto &rows = (*po).second;
+
+    auto pr = std::lower_bound(rows.begin(), rows.end(), row);
+
+    if (pr != rows.end() && *pr == row) {
+      rows.erase(pr);
+
+      if (rows.size() == 1)
+        --columnIndex.numDuplicates;
+    }
+
+    if (rows.empty())
+      columnIndex.valueRows.erase(po);
+  }
+
+  // add row to new value rows (keep sorted)
+  auto &rows = columnIndex.valueRows[newKey];
+
+  rows.insert(std::lower_bound(rows.begin(), rows.end(), row), row);
+
+  if (rows.size() == 2)
+    ++columnIndex.numDuplicates;
+}
+
+// add rows (appended to data) to built column indices. Called with mutex write locked.
+void
+CQDataModel::
+addColumnIndexRows(int row, int n)
+{
+  for (auto &pi : columnIndices_) {
+    auto &columnIndex = pi.second;
+
+    // not built yet so nothing to update
+    if (! columnIndex.valid)
+      continue;
+
+    auto dc = size_t(dataColumn(pi.first));
+
+    // rows are after all indexed rows so row lists stay sorted
+    for (int r = row; r < row + n; ++r) {
+      const auto &cells = data_[size_t(r)];
+
+      auto var = (dc < cells.size() ? cells[dc] : QVariant());
+
+      auto &rows = columnIndex.valueRows[columnIndexKey(var)];
+
+      rows.push_back(r);
+
+      if (rows.size() == 2)
+        ++columnIndex.numDuplicates;
+    }
+  }
+}
+
+void
+CQDataModel::
+invalidateColumnIndices()
+{
+  WriteLock lock(mutex_);
+
+  for (auto &pi : columnIndices_) {
+    auto &columnIndex = pi.second;
+
+    columnIndex.valid         = false;
+    columnIndex.numDuplicates = 0;
+
+    columnIndex.valueRows.clear();
+  }
+}
+
+QString
+CQDataModel::
+columnIndexKey(const QVariant &var)
+{
+  // key includes value type so only equal values share a key
+  return CQModelUtil::variantKey(var);
+}
+
+QStringList
+CQDataModel::
+columnIndexKeys(const QVariant &var)
+{
+  // QVariant == converts between string, numeric and bool values so a lookup value
+  // can match cells with the key of any of these forms of the value
+  QStringList keys;
+
+  auto addKey = [&](const QVariant &var1) {
+    auto key = columnIndexKey(var1);
+
+    if (! keys.contains(key))
+      keys.push_back(key);
+  };
+
+  addKey(var);
+
+  if (! var.isValid())
+    return keys;
+
+  if (var.canConvert<QString>())
+    addKey(QVariant(var.toString()));
+
+  bool ok;
+
+  double r = var.toDouble(&ok);
+
+  if (ok)
+    addKey(QVariant(r));
+
+  if (var.canConvert<bool>())
+    addKey(QVariant(var.toBool()));
+
+  return keys;
+}
+
+//------
+
+QVariant
+CQDataModel::Snapshot::
+value(int row, int column) const
+{
+  if (row < 0 || size_t(row) >= data_.size() || column < 0 || column >= numColumns())
+    return QVariant();
+
+  const auto &cells = data_[size_t(row)];
+
+  auto dc = size_t(dataColumn(column));
+
+  if (dc >= cells.size())
+    return QVariant();
+
+  return cells[dc];
+}
+
+QVariant
+CQDataModel::Snapshot::
+headerValue(int column) const
+{
+  if (column < 0 || column >= numColumns())
+    return QVariant();
+
+  return hheader_[size_t(dataColumn(column))];
 }
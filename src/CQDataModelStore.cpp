@@ -0,0 +1,225 @@
+#include <CQDataModelStore.h>
+#include <algorithm>
+#include <iterator>
+#include <cassert>
+
+const CQDataModelStore::Cells &
+CQDataModelStore::
+operator[](size_t r) const
+{
+  assert(r < numRows_);
+
+  size_t ic;
+
+  auto i = locate(r, ic);
+
+  return (*table_->chunks[ic])[i];
+}
+
+CQDataModelStore::Cells &
+CQDataModelStore::
+modifyRow(size_t r)
+{
+  assert(r < numRows_);
+
+  ++version_;
+
+  size_t ic;
+
+  auto i = locate(r, ic);
+
+  return detachChunk(ic)[i];
+}
+
+void
+CQDataModelStore::
+push_back(const Cells &cells)
+{
+  auto &table = detachTable();
+
+  if (table.chunks.empty() || table.chunks.back()->size() >= chunkRows)
+    addChunk(0);
+
+  detachChunk(table.chunks.size() - 1).push_back(cells);
+
+  ++numRows_;
+  ++version_;
+}
+
+void
+CQDataModelStore::
+erase(size_t r)
+{
+  assert(r < numRows_);
+
+  auto &table = detachTable();
+
+  // remove row from its chunk only (later chunks are shifted by updating their start)
+  size_t ic;
+
+  auto i = locate(r, ic);
+
+  auto &chunk = detachChunk(ic);
+
+  chunk.erase(chunk.begin() + long(i));
+
+  for (auto j = ic + 1; j < table.starts.size(); ++j)
+    --table.starts[j];
+
+  if (ic + 1 < table.chunks.size())
+    table.even = false;
+
+  if      (chunk.empty()) {
+    table.chunks.erase(table.chunks.begin() + long(ic));
+    table.starts.erase(table.starts.begin() + long(ic));
+  }
+  // merge small chunk with next chunk to limit number of chunks
+  else if (chunk.size() < chunkRows/4 && ic + 1 < table.chunks.size() &&
+           chunk.size() + table.chunks[ic + 1]->size() <= chunkRows) {
+    auto &nextChunk = table.chunks[ic + 1];
+
+    if (nextChunk.use_count() > 1)
+      chunk.insert(chunk.end(), nextChunk->begin(), nextChunk->end());
+    else
+      std::move(nextChunk->begin(), nextChunk->end(), std::back_inserter(chunk));
+
+    table.chunks.erase(table.chunks.begin() + long(ic + 1));
+    table.starts.erase(table.starts.begin() + long(ic + 1));
+  }
+
+  --numRows_;
+  ++version_;
+}
+
+void
+CQDataModelStore::
+resize(size_t n)
+{
+  if (n == numRows_)
+    return;
+
+  if (n == 0) {
+    clear();
+    return;
+  }
+
+  auto &table = detachTable();
+
+  if (n < numRows_) {
+    // truncate chunk containing last kept row and remove later chunks
+    size_t ic;
+
+    auto i = locate(n - 1, ic);
+
+    table.chunks.resize(ic + 1);
+    table.starts.resize(ic + 1);
+
+    if (table.chunks[ic]->size() != i + 1)
+      detachChunk(ic).resize(i + 1);
+  }
+  else {
+    // fill last chunk then add new chunks
+    if (! table.chunks.empty() && table.chunks.back()->size() < chunkRows)
+      detachChunk(table.chunks.size() - 1).resize(
+        std::min(table.chunks.back()->size() + n - numRows_, chunkRows));
+
+    auto nr = (table.chunks.empty() ? 0 : table.starts.back() + table.chunks.back()->size());
+
+    while (nr < n) {
+      auto nr1 = std::min(n - nr, chunkRows);
+
+      addChunk(nr1);
+
+      nr += nr1;
+    }
+  }
+
+  numRows_ = n;
+
+  ++version_;
+}
+
+void
+CQDataModelStore::
+clear()
+{
+  // other copies keep old chunks
+  table_.reset();
+
+  numRows_ = 0;
+
+  ++version_;
+}
+
+bool
+CQDataModelStore::
+isShared() const
+{
+  return (table_ && table_.use_count() > 1);
+}
+
+size_t
+CQDataModelStore::
+locate(size_t r, size_t &ic) const
+{
+  // full chunks so chunk from row
+  if (table_->even) {
+    ic = r/chunkRows;
+
+    return r % chunkRows;
+  }
+
+  // last chunk with start <= r
+  const auto &starts = table_->starts;
+
+  auto p = std::upper_bound(starts.begin(), starts.end(), r);
+
+  ic = size_t(p - starts.begin()) - 1;
+
+  return r - starts[ic];
+}
+
+CQDataModelStore::Table &
+CQDataModelStore::
+detachTable()
+{
+  // copy chunk table if shared (chunks are shared by both tables)
+  if      (! table_)
+    table_ = std::make_shared<Table>();
+  else if (table_.use_count() > 1)
+    table_ = std::make_shared<Table>(*table_);
+
+  return *table_;
+}
+
+CQDataModelStore::Chunk &
+CQDataModelStore::
+detachChunk(size_t i)
+{
+  auto &table = detachTable();
+
+  auto &chunk = table.chunks[i];
+
+  // copy chunk if shared with another table
+  if (chunk.use_count() > 1)
+    chunk = std::make_shared<Chunk>(*chunk);
+
+  return *chunk;
+}
+
+void
+CQDataModelStore::
+addChunk(size_t nr)
+{
+  // called with table detached
+  auto &table = *table_;
+
+  auto start = (table.chunks.empty() ? 0 : table.starts.back() + table.chunks.back()->size());
+
+  auto chunk = std::make_shared<Chunk>(nr);
+
+  chunk->reserve(chunkRows);
+
+  table.chunks.push_back(chunk);
+  table.starts.push_back(start);
+}
@@ -1,12 +1,17 @@
 #include <CQModelDetails.h>
 #include <CQModelVisitor.h>
 #include <CQBaseModel.h>
+#include <CQDataModel.h>
 #include <CQModelUtil.h>
 #include <CQValueSet.h>
 //#include <CQPerfMonitor.h>
 
 #include <QAbstractItemModel>
 
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
 namespace {
 
 long varToInt(const QVariant &var, bool *ok) {
@@ -18,6 +23,72 @@ long varToInt(const QVariant &var, bool *ok) {
   return var.toInt(ok);
 }
 
+//! min/max and monotonic state of column values of native type
+template<typename T>
+class ValueAccumulator {
+ public:
+  ValueAccumulator() { }
+
+  void add(const T &v) {
+    // update min/max value
+    if (! set_) {
+      min_ = v;
+      max_ = v;
+      set_ = true;
+    }
+    else {
+      min_ = std::min(min_, v);
+      max_ = std::max(max_, v);
+    }
+
+    // update monotonic from previous two values
+    if (numLast_ == 2) {
+      if (! monotonicSet_) {
+        if (last1_ != last2_) {
+          increasing_   = (last2_ > last1_);
+          monotonicSet_ = true;
+        }
+      }
+      else {
+        if (monotonic_) {
+          if (increasing_) {
+            if (last2_ < last1_)
+              monotonic_ = false;
+          }
+          else {
+            if (last2_ > last1_)
+              monotonic_ = false;
+          }
+        }
+      }
+    }
+
+    last1_ = last2_;
+    last2_ = v;
+
+    numLast_ = std::min(numLast_ + 1, 2);
+  }
+
+  bool isSet() const { return set_; }
+
+  const T &min() const { return min_; }
+  const T &max() const { return max_; }
+
+  bool isMonotonic () const { return monotonicSet_ && monotonic_; }
+  bool isIncreasing() const { return increasing_; }
+
+ private:
+  bool set_          { false }; //!< has value
+  T    min_          {};        //!< min value
+  T    max_          {};        //!< max value
+  T    last1_        {};        //!< previous but one value
+  T    last2_        {};        //!< previous value
+  int  numLast_      { 0 };     //!< number of previous values
+  bool monotonicSet_ { false }; //!< is monotonic direction set
+  bool monotonic_    { true };  //!< is monotonic
+  bool increasing_   { true };  //!< is increasing
+};
+
 }
 
 //------
@@ -243,70 +314,249 @@ std::vector<int>
 CQModelDetails::
 duplicates(int column) const
 {
-  return columnDuplicates(column, false);
+  // key columns of data model keep a unique index of raw values so just probe it. Edit
+  // role values (used by hash) only differ from raw values for numeric column types
+  // (string cells converted to numbers)
+  auto *dataModel = dynamic_cast<const CQDataModel *>(model());
+
+  if (dataModel && dataModel->isColumnKey(column)) {
+    auto type = dataModel->columnType(column);
+
+    if (type != CQBaseModelType::REAL && type != CQBaseModelType::INTEGER)
+      return dataModel->keyDuplicates(column);
+  }
+
+  std::vector<int> rows;
+
+  for (const auto &set : columnDuplicateSets(column, false))
+    rows.insert(rows.end(), set.begin() + 1, set.end());
+
+  std::sort(rows.begin(), rows.end());
+
+  return rows;
 }
 
 std::vector<int>
 CQModelDetails::
 duplicates() const
 {
-  return columnDuplicates(-1, true);
+  std::vector<int> rows;
+
+  for (const auto &set : columnDuplicateSets(-1, true))
+    rows.insert(rows.end(), set.begin() + 1, set.end());
+
+  std::sort(rows.begin(), rows.end());
+
+  return rows;
 }
 
-std::vector<int>
+CQModelDetails::DuplicateSets
+CQModelDetails::
+duplicateSets(int column) const
+{
+  return columnDuplicateSets(column, false);
+}
+
+CQModelDetails::DuplicateSets
 CQModelDetails::
-columnDuplicates(int column, bool all) const
+duplicateSets() const
+{
+  return columnDuplicateSets(-1, true);
+}
+
+CQModelDetails::DuplicateSets
+CQModelDetails::
+columnDuplicateSets(int column, bool all) const
 {
   initSimpleData();
 
+  DuplicateSets sets;
+
+  if (! all && (column < 0 || column >= numColumns_))
+    return sets;
+
   //---
 
-  std::vector<QVariant> rowValues1, rowValues2;
+  // hash rows (in parallel chunks)
+  RowHashes hashes;
 
-  if (all)
-    rowValues2.resize(size_t(numColumns_));
-  else
-    rowValues2.resize(1);
+  calcRowHashes(column, all, hashes);
 
-  std::vector<int> rows;
+  //---
+
+  // group rows with equal hashes and split each group into sets of equal values
+  if (isLowMemory()) {
+    // sort rows by hash so equal hashes are adjacent
+    std::vector<int> rows;
+
+    rows.resize(size_t(numRows_));
+
+    for (int r = 0; r < numRows_; ++r)
+      rows[size_t(r)] = r;
 
-  for (int r = 0; r < numRows_; ++r) {
-    bool match = true;
+    std::sort(rows.begin(), rows.end(), [&](int r1, int r2) {
+      auto h1 = hashes[size_t(r1)], h2 = hashes[size_t(r2)];
+      return (h1 != h2 ? h1 < h2 : r1 < r2);
+    });
 
-    if (all) {
-      for (int c = 0; c < numColumns_; ++c) {
-        QModelIndex parent;
+    DuplicateRows collisionRows;
 
-        bool ok;
+    for (size_t i = 0; i < rows.size(); ) {
+      size_t j = i + 1;
 
-        auto var = CQModelUtil::modelValue(model(), r, c, parent, ok);
+      while (j < rows.size() && hashes[size_t(rows[j])] == hashes[size_t(rows[i])])
+        ++j;
 
-        rowValues2[size_t(c)] = var;
+      if (j - i > 1) {
+        collisionRows.assign(rows.begin() + long(i), rows.begin() + long(j));
 
-        if (rowValues1.empty() || var != rowValues1[size_t(c)])
-          match = false;
+        addCollisionSets(collisionRows, column, all, sets);
       }
-    }
-    else {
-      QModelIndex parent;
 
-      bool ok;
+      i = j;
+    }
+  }
+  else {
+    std::unordered_map<size_t, DuplicateRows> hashRows;
 
-      auto var = CQModelUtil::modelValue(model(), r, column, parent, ok);
+    hashRows.reserve(size_t(numRows_));
 
-      rowValues2[0] = var;
+    for (int r = 0; r < numRows_; ++r)
+      hashRows[hashes[size_t(r)]].push_back(r);
 
-      if (rowValues1.empty() || var != rowValues1[0])
-        match = false;
+    for (const auto &phr : hashRows) {
+      if (phr.second.size() > 1)
+        addCollisionSets(phr.second, column, all, sets);
     }
+  }
+
+  // order sets by first row
+  std::sort(sets.begin(), sets.end(), [](const DuplicateRows &rows1, const DuplicateRows &rows2) {
+    return rows1[0] < rows2[0];
+  });
+
+  return sets;
+}
+
+void
+CQModelDetails::
+calcRowHashes(int column, bool all, RowHashes &hashes) const
+{
+  hashes.resize(size_t(numRows_));
+
+  auto hashRows = [&](int r1, int r2) {
+    for (int r = r1; r < r2; ++r)
+      hashes[size_t(r)] = rowHash(r, column, all);
+  };
+
+  // split rows into chunks of at least minChunkRows for each thread
+  const int minChunkRows = 16384;
 
-    if (match)
-      rows.push_back(r);
+  int numThreads = int(std::thread::hardware_concurrency());
 
-    rowValues1 = rowValues2;
+  numThreads = std::max(std::min(numThreads, numRows_/minChunkRows), 1);
+
+  // only data model (locked cell data) is safe to read from worker threads,
+  // other models are hashed on the calling thread
+  if (! dynamic_cast<const CQDataModel *>(model()))
+    numThreads = 1;
+
+  if (numThreads == 1) {
+    hashRows(0, numRows_);
+    return;
   }
 
-  return rows;
+  int chunkRows = (numRows_ + numThreads - 1)/numThreads;
+
+  std::vector<std::future<void>> futures;
+
+  for (int r = 0; r < numRows_; r += chunkRows)
+    futures.push_back(std::async(std::launch::async, hashRows, r,
+                                 std::min(r + chunkRows, numRows_)));
+
+  for (auto &future : futures)
+    future.get();
+}
+
+size_t
+CQModelDetails::
+rowHash(int row, int column, bool all) const
+{
+  QModelIndex parent;
+
+  auto columnHash = [&](int c) {
+    bool ok;
+
+    auto var = CQModelUtil::modelValue(model(), row, c, parent, ok);
+
+    // hash and equality both use variant key (same rule as key column duplicates)
+    return size_t(qHash(CQModelUtil::variantKey(var)));
+  };
+
+  if (! all)
+    return columnHash(column);
+
+  size_t hash = 0;
+
+  for (int c = 0; c < numColumns_; ++c)
+    hash ^= columnHash(c) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+  return hash;
+}
+
+bool
+CQModelDetails::
+rowValuesEqual(int row1, int row2, int column, bool all) const
+{
+  QModelIndex parent;
+
+  auto columnEqual = [&](int c) {
+    bool ok1, ok2;
+
+    auto var1 = CQModelUtil::modelValue(model(), row1, c, parent, ok1);
+    auto var2 = CQModelUtil::modelValue(model(), row2, c, parent, ok2);
+
+    return (CQModelUtil::variantKey(var1) == CQModelUtil::variantKey(var2));
+  };
+
+  if (! all)
+    return columnEqual(column);
+
+  for (int c = 0; c < numColumns_; ++c) {
+    if (! columnEqual(c))
+      return false;
+  }
+
+  return true;
+}
+
+void
+CQModelDetails::
+addCollisionSets(const DuplicateRows &rows, int column, bool all, DuplicateSets &sets) const
+{
+  // rows have equal hashes (in increasing row order) so split into sets of
+  // equal values (usually one)
+  DuplicateSets hashSets;
+
+  for (const auto &r : rows) {
+    bool found = false;
+
+    for (auto &hashSet : hashSets) {
+      if (rowValuesEqual(hashSet[0], r, column, all)) {
+        hashSet.push_back(r);
+        found = true;
+        break;
+      }
+    }
+
+    if (! found)
+      hashSets.push_back(DuplicateRows({ r }));
+  }
+
+  for (auto &hashSet : hashSets) {
+    if (hashSet.size() > 1)
+      sets.push_back(std::move(hashSet));
+  }
 }
 
 //------
@@ -576,11 +826,9 @@ numUnique() const
   else if (type() == CQBaseModelType::REAL) {
     return valueSet_->rvals().numUnique();
   }
-  else if (type() == CQBaseModelType::STRING) {
-    return valueSet_->svals().numUnique();
-  }
   else {
-    return 0;
+    // other types (string, color, time, ...) are added as strings
+    return valueSet_->svals().numUnique();
   }
 }
 
@@ -608,7 +856,7 @@ uniqueValues() const
     for (const auto &v : values)
       vars.push_back(v);
   }
-  else if (type() == CQBaseModelType::STRING) {
+  else {
     CQSValues::Values values;
 
     valueSet_->svals().uniqueValues(values);
@@ -634,7 +882,7 @@ uniqueCounts() const
   else if (type() == CQBaseModelType::REAL) {
     valueSet_->rvals().uniqueCounts(counts);
   }
-  else if (type() == CQBaseModelType::STRING) {
+  else {
     valueSet_->svals().uniqueCounts(counts);
   }
 
@@ -665,7 +913,7 @@ uniqueId(const QVariant &var) const
 
     return valueSet_->rvals().id(r);
   }
-  else if (type() == CQBaseModelType::STRING) {
+  else {
     return valueSet_->svals().id(var.toString());
   }
 
@@ -703,18 +951,6 @@ numNull() const
   return 0;
 }
 
-int
-CQModelColumnDetails::
-valueInd(const QVariant &value) const
-{
-  auto p = valueInds_.find(value);
-
-  if (p == valueInds_.end())
-    return -1;
-
-  return (*p).second;
-}
-
 QVariant
 CQModelColumnDetails::
 medianValue(bool useNaN) const
@@ -888,10 +1124,7 @@ initData()
   class DetailVisitor : public CQModelVisitor {
    public:
     DetailVisitor(CQModelColumnDetails *details) :
-     details_(details) {
-      monotonicSet_ = false;
-      monotonic_    = true;
-      increasing_   = true;
+     details_(details), type_(details->type()) {
     }
 
     // visit row
@@ -901,9 +1134,7 @@ initData()
       auto var = CQModelUtil::modelValue(model, data.row, details_->column(), data.parent, ok);
       if (! ok) return State::SKIP;
 
-      details_->addValue(var);
-
-      if      (details_->type() == CQBaseModelType::INTEGER) {
+      if      (type_ == CQBaseModelType::INTEGER) {
         long i = varToInt(var, &ok);
         if (! ok) return State::SKIP;
 
@@ -912,9 +1143,9 @@ initData()
 
         details_->addInt(i);
 
-        addInt(i);
+        ivalues_.add(i);
       }
-      else if (details_->type() == CQBaseModelType::REAL) {
+      else if (type_ == CQBaseModelType::REAL) {
         double r = var.toDouble(&ok);
         if (! ok) return State::SKIP;
 
@@ -923,17 +1154,7 @@ initData()
 
         details_->addReal(r);
 
-        addReal(r);
-      }
-      else if (details_->type() == CQBaseModelType::STRING) {
-        auto s = var.toString();
-
-        if (! details_->checkRow(s))
-          return State::SKIP;
-
-        details_->addString(s);
-
-        addString(s);
+        rvalues_.add(r);
       }
       else {
         auto s = var.toString();
@@ -943,186 +1164,49 @@ initData()
 
         details_->addString(s);
 
-        addString(s);
+        svalues_.add(s);
       }
 
       return State::OK;
     }
 
-    void addInt(long i) {
-      // if no type defined min, update min value
-      if (visitMin_) {
-        bool ok1;
-
-        long imin = varToInt(min_, &ok1);
-
-        imin = (! ok1 ? i : std::min(imin, i));
-
-        min_ = CQModelUtil::intVariant(imin);
-      }
-
-      // if no type defined max, update max value
-      if (visitMax_) {
-        bool ok1;
-
-        long imax = varToInt(max_, &ok1);
-
-        imax = (! ok1 ? i : std::max(imax, i));
-
-        max_ = CQModelUtil::intVariant(imax);
-      }
-
-      if (lastValue1_.isValid() && lastValue2_.isValid()) {
-        bool ok1, ok2;
-
-        long i1 = varToInt(lastValue1_, &ok1);
-        long i2 = varToInt(lastValue2_, &ok2);
-
-        if (! monotonicSet_) {
-          if (i1 != i2) {
-            increasing_   = (i2 > i1);
-            monotonicSet_ = true;
-          }
-        }
-        else {
-          if (monotonic_) {
-            if (increasing_) {
-              if (i2 < i1)
-                monotonic_ = false;
-            }
-            else {
-              if (i2 > i1)
-                monotonic_ = false;
-            }
-          }
-        }
-      }
-
-      lastValue1_ = lastValue2_;
-      lastValue2_ = CQModelUtil::intVariant(i);
+    // min/max (boxed from native values)
+    QVariant minValue() const {
+      if      (type_ == CQBaseModelType::INTEGER)
+        return (ivalues_.isSet() ? CQModelUtil::intVariant(ivalues_.min()) : QVariant());
+      else if (type_ == CQBaseModelType::REAL)
+        return (rvalues_.isSet() ? QVariant(rvalues_.min()) : QVariant());
+      else
+        return (svalues_.isSet() ? QVariant(svalues_.min()) : QVariant());
     }
 
-    void addReal(double r) {
-      // if no type defined min, update min value
-      if (visitMin_) {
-        bool ok1;
-
-        double rmin = min_.toDouble(&ok1);
-
-        rmin = (! ok1 ? r : std::min(rmin, r));
-
-        min_ = QVariant(rmin);
-      }
-
-      // if no type defined max, update max value
-      if (visitMax_) {
-        bool ok1;
-
-        double rmax = max_.toDouble(&ok1);
-
-        rmax = (! ok1 ? r : std::max(rmax, r));
-
-        max_ = QVariant(rmax);
-      }
-
-      if (lastValue1_.isValid() && lastValue2_.isValid()) {
-        bool ok1, ok2;
-
-        double r1 = lastValue1_.toDouble(&ok1);
-        double r2 = lastValue2_.toDouble(&ok2);
-
-        if (! monotonicSet_) {
-          if (r1 != r2) {
-            increasing_   = (r2 > r1);
-            monotonicSet_ = true;
-          }
-        }
-        else {
-          if (monotonic_) {
-            if (increasing_) {
-              if (r2 < r1)
-                monotonic_ = false;
-            }
-            else {
-              if (r2 > r1)
-                monotonic_ = false;
-            }
-          }
-        }
-      }
-
-      lastValue1_ = lastValue2_;
-      lastValue2_ = CQModelUtil::realVariant(r);
+    QVariant maxValue() const {
+      if      (type_ == CQBaseModelType::INTEGER)
+        return (ivalues_.isSet() ? CQModelUtil::intVariant(ivalues_.max()) : QVariant());
+      else if (type_ == CQBaseModelType::REAL)
+        return (rvalues_.isSet() ? QVariant(rvalues_.max()) : QVariant());
+      else
+        return (svalues_.isSet() ? QVariant(svalues_.max()) : QVariant());
     }
 
-    void addString(const QString &s) {
-      // if no type defined min, update min value
-      if (visitMin_) {
-        bool ok1 = min_.isValid();
-
-        auto smin = min_.toString();
-
-        smin = (! ok1 ? s : std::min(smin, s));
-
-        min_ = QVariant(smin);
-      }
-
-      // if no type defined max, update max value
-      if (visitMax_) {
-        bool ok1 = min_.isValid();
-
-        auto smax = max_.toString();
-
-        smax = (! ok1 ? s : std::max(smax, s));
-
-        max_ = QVariant(smax);
-      }
-
-      if (lastValue1_.isValid() && lastValue2_.isValid()) {
-        auto s1 = lastValue1_.toString();
-        auto s2 = lastValue2_.toString();
-
-        if (! monotonicSet_) {
-          if (s1 != s2) {
-            increasing_   = (s2 > s1);
-            monotonicSet_ = true;
-          }
-        }
-        else {
-          if (monotonic_) {
-            if (increasing_) {
-              if (s2 < s1)
-                monotonic_ = false;
-            }
-            else {
-              if (s2 > s1)
-                monotonic_ = false;
-            }
-          }
-        }
-      }
-
-      lastValue1_ = lastValue2_;
-      lastValue2_ = QVariant(s);
+    bool isMonotonic() const {
+      if      (type_ == CQBaseModelType::INTEGER) return ivalues_.isMonotonic();
+      else if (type_ == CQBaseModelType::REAL   ) return rvalues_.isMonotonic();
+      else                                        return svalues_.isMonotonic();
     }
 
-    QVariant minValue() const { return min_; }
-    QVariant maxValue() const { return max_; }
-
-    bool isMonotonic () const { return monotonicSet_ && monotonic_; }
-    bool isIncreasing() const { return increasing_; }
+    bool isIncreasing() const {
+      if      (type_ == CQBaseModelType::INTEGER) return ivalues_.isIncreasing();
+      else if (type_ == CQBaseModelType::REAL   ) return rvalues_.isIncreasing();
+      else                                        return svalues_.isIncreasing();
+    }
 
    private:
-    CQModelColumnDetails* details_      { nullptr };
-    QVariant              min_;
-    QVariant              max_;
-    bool                  visitMin_     { true };
-    bool                  visitMax_     { true };
-    QVariant              lastValue1_;
-    QVariant              lastValue2_;
-    bool                  monotonicSet_ { false };
-    bool                  monotonic_    { true };
-    bool                  increasing_   { true };
+    CQModelColumnDetails*     details_ { nullptr };               //!< column details
+    CQBaseModelType           type_    { CQBaseModelType::NONE }; //!< column type
+    ValueAccumulator<long>    ivalues_;                           //!< integer values
+    ValueAccumulator<double>  rvalues_;                           //!< real values
+    ValueAccumulator<QString> svalues_;                           //!< string values
   };
 
   //---
@@ -1225,16 +1309,3 @@ addString(const QString &s)
 {
   valueSet_->svals().addValue(s);
 }
-
-void
-CQModelColumnDetails::
-addValue(const QVariant &value)
-{
-  auto p = valueInds_.find(value);
-
-  if (p == valueInds_.end()) {
-    int ind = int(valueInds_.size());
-
-    (void) valueInds_.insert(p, VariantInds::value_type(value, ind));
-  }
-}
@@ -0,0 +1,362 @@
+#include <CQModelGroupBy.h>
+#include <CQDataModel.h>
+#include <CQModelUtil.h>
+
+#include <QAbstractItemModel>
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+CQModelGroupBy::
+CQModelGroupBy(QAbstractItemModel *model) :
+ model_(model)
+{
+}
+
+CQDataModel *
+CQModelGroupBy::
+exec() const
+{
+  int nr = (model_ ? model_->rowCount() : 0);
+
+  //---
+
+  // group rows in chunks of at least minChunkRows for each thread
+  const int minChunkRows = 16384;
+
+  int numThreads = numThreads_;
+
+  if (numThreads <= 0)
+    numThreads = int(std::thread::hardware_concurrency());
+
+  numThreads = std::max(std::min(numThreads, nr/minChunkRows), 1);
+
+  // only data model (locked cell data) is safe to read from worker threads
+  if (! dynamic_cast<const CQDataModel *>(model_))
+    numThreads = 1;
+
+  Groups groups;
+
+  if (numThreads == 1) {
+    groupRows(0, nr, groups);
+  }
+  else {
+    int chunkRows = (nr + numThreads - 1)/numThreads;
+
+    std::vector<Groups> threadGroups;
+
+    threadGroups.resize(size_t(numThreads));
+
+    std::vector<std::future<void>> futures;
+
+    for (int i = 0; i < numThreads; ++i) {
+      int r1 = i*chunkRows;
+      int r2 = std::min(r1 + chunkRows, nr);
+
+      auto &groups1 = threadGroups[size_t(i)];
+
+      futures.push_back(std::async(std::launch::async, [this, r1, r2, &groups1]() {
+        groupRows(r1, r2, groups1);
+      }));
+    }
+
+    for (auto &future : futures)
+      future.get();
+
+    // merge partial tables
+    groups = std::move(threadGroups[0]);
+
+    for (int i = 1; i < numThreads; ++i)
+      mergeGroups(groups, threadGroups[size_t(i)]);
+  }
+
+  //---
+
+  // order groups by first row
+  std::vector<GroupData *> groupDatas;
+
+  groupDatas.reserve(groups.size());
+
+  for (auto &pg : groups)
+    groupDatas.push_back(&pg.second);
+
+  std::sort(groupDatas.begin(), groupDatas.end(), [](GroupData *g1, GroupData *g2) {
+    return g1->row < g2->row;
+  });
+
+  //---
+
+  // create result model
+  int nk = int(keyColumns_.size());
+  int na = int(aggregates_.size());
+
+  auto *dataModel = new CQDataModel(nk + na, int(groupDatas.size()));
+
+  for (int c = 0; c < nk; ++c) {
+    bool ok;
+
+    auto name = CQModelUtil::modelHeaderString(model_, keyColumns_[size_t(c)], ok);
+
+    dataModel->setHeaderData(c, Qt::Horizontal, name, Qt::DisplayRole);
+  }
+
+  for (int c = 0; c < na; ++c) {
+    const auto &aggregate = aggregates_[size_t(c)];
+
+    dataModel->setHeaderData(nk + c, Qt::Horizontal, aggregateName(aggregate), Qt::DisplayRole);
+
+    if (aggregate.type == AggregateType::COUNT)
+      dataModel->setColumnType(nk + c, CQBaseModelType::INTEGER);
+    else
+      dataModel->setColumnType(nk + c, CQBaseModelType::REAL);
+  }
+
+  int r = 0;
+
+  for (auto *groupData : groupDatas) {
+    for (int c = 0; c < nk; ++c)
+      dataModel->setModelData(r, c, groupData->keyValues[c]);
+
+    for (int c = 0; c < na; ++c) {
+      const auto &aggregate = aggregates_[size_t(c)];
+
+      auto &aggregateData = groupData->aggregateDatas[size_t(c)];
+
+      dataModel->setModelData(r, nk + c, aggregateData.value(aggregate.type));
+    }
+
+    ++r;
+  }
+
+  return dataModel;
+}
+
+void
+CQModelGroupBy::
+groupRows(int r1, int r2, Groups &groups) const
+{
+  QModelIndex parent;
+
+  auto na = aggregates_.size();
+
+  GroupKey key;
+
+  for (int r = r1; r < r2; ++r) {
+    // get row key from key column values
+    QVariantList keyValues;
+
+    key.clear();
+
+    for (const auto &c : keyColumns_) {
+      bool ok;
+
+      auto var = CQModelUtil::modelValue(model_, r, c, parent, ok);
+
+      keyValues.push_back(var);
+
+      key.push_back(CQModelUtil::variantKey(var));
+    }
+
+    //---
+
+    auto pg = groups.find(key);
+
+    if (pg == groups.end()) {
+      GroupData groupData;
+
+      groupData.row       = r;
+      groupData.keyValues = keyValues;
+
+      groupData.aggregateDatas.resize(na);
+
+      pg = groups.insert(pg, Groups::value_type(key, std::move(groupData)));
+    }
+
+    auto &groupData = (*pg).second;
+
+    //---
+
+    // add row values to aggregates
+    for (size_t i = 0; i < na; ++i) {
+      const auto &aggregate = aggregates_[i];
+
+      auto &aggregateData = groupData.aggregateDatas[i];
+
+      if (aggregate.column < 0) {
+        ++aggregateData.count;
+        continue;
+      }
+
+      auto ind = model_->index(r, aggregate.column, parent);
+
+      bool ok;
+
+      auto value = CQModelUtil::modelReal(model_, ind, ok);
+
+      ++aggregateData.count;
+
+      if (ok)
+        aggregateData.addValue(value, aggregate.type == AggregateType::MEDIAN);
+    }
+  }
+}
+
+void
+CQModelGroupBy::
+mergeGroups(Groups &groups, Groups &groups1) const
+{
+  for (auto &pg1 : groups1) {
+    auto pg = groups.find(pg1.first);
+
+    if (pg == groups.end()) {
+      groups.insert(Groups::value_type(pg1.first, std::move(pg1.second)));
+      continue;
+    }
+
+    auto &groupData  = (*pg).second;
+    auto &groupData1 = pg1.second;
+
+    if (groupData1.row < groupData.row) {
+      groupData.row       = groupData1.row;
+      groupData.keyValues = groupData1.keyValues;
+    }
+
+    for (size_t i = 0; i < groupData.aggregateDatas.size(); ++i)
+      groupData.aggregateDatas[i].merge(groupData1.aggregateDatas[i]);
+  }
+
+  groups1.clear();
+}
+
+//---
+
+QString
+CQModelGroupBy::
+aggregateName(const Aggregate &aggregate) const
+{
+  if (aggregate.name.length())
+    return aggregate.name;
+
+  auto typeName = aggregateTypeName(aggregate.type);
+
+  if (aggregate.column < 0)
+    return typeName;
+
+  bool ok;
+
+  auto name = CQModelUtil::modelHeaderString(model_, aggregate.column, ok);
+
+  return QString("%1(%2)").arg(typeName).arg(name);
+}
+
+QString
+CQModelGroupBy::
+aggregateTypeName(AggregateType type)
+{
+  switch (type) {
+    case AggregateType::COUNT : return "count";
+    case AggregateType::SUM   : return "sum";
+    case AggregateType::MIN   : return "min";
+    case AggregateType::MAX   : return "max";
+    case AggregateType::MEAN  : return "mean";
+    case AggregateType::MEDIAN: return "median";
+    default                   : return "";
+  }
+}
+
+bool
+CQModelGroupBy::
+nameToAggregateType(const QString &name, AggregateType &type)
+{
+  auto lname = name.toLower();
+
+  if      (lname == "count" ) type = AggregateType::COUNT;
+  else if (lname == "sum"   ) type = AggregateType::SUM;
+  else if (lname == "min"   ) type = AggregateType::MIN;
+  else if (lname == "max"   ) type = AggregateType::MAX;
+  else if (lname == "mean"  ) type = AggregateType::MEAN;
+  else if (lname == "median") type = AggregateType::MEDIAN;
+  else return false;
+
+  return true;
+}
+
+//------
+
+void
+CQModelGroupBy::AggregateData::
+addValue(double r, bool keepValues)
+{
+  if (nvalue == 0) {
+    min = r;
+    max = r;
+  }
+  else {
+    min = std::min(min, r);
+    max = std::max(max, r);
+  }
+
+  sum += r;
+
+  ++nvalue;
+
+  if (keepValues)
+    values.push_back(r);
+}
+
+void
+CQModelGroupBy::AggregateData::
+merge(const AggregateData &data)
+{
+  if (data.nvalue > 0) {
+    if (nvalue == 0) {
+      min = data.min;
+      max = data.max;
+    }
+    else {
+      min = std::min(min, data.min);
+      max = std::max(max, data.max);
+    }
+  }
+
+  count  += data.count;
+  nvalue += data.nvalue;
+  sum    += data.sum;
+
+  values.insert(values.end(), data.values.begin(), data.values.end());
+}
+
+QVariant
+CQModelGroupBy::AggregateData::
+value(AggregateType type)
+{
+  if (type == AggregateType::COUNT)
+    return QVariant(count);
+
+  if (nvalue == 0)
+    return QVariant();
+
+  switch (type) {
+    case AggregateType::SUM : return QVariant(sum);
+    case AggregateType::MIN : return QVariant(min);
+    case AggregateType::MAX : return QVariant(max);
+    case AggregateType::MEAN: return QVariant(sum/nvalue);
+    case AggregateType::MEDIAN: {
+      auto nv = values.size();
+
+      auto pm = values.begin() + long(nv/2);
+
+      std::nth_element(values.begin(), pm, values.end());
+
+      if (nv & 1)
+        return QVariant(*pm);
+
+      auto pl = std::max_element(values.begin(), pm);
+
+      return QVariant((*pl + *pm)/2.0);
+    }
+    default:
+      return QVariant();
+  }
+}
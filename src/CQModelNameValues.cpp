@@ -1,18 +1,58 @@
 #include <CQModelNameValues.h>
-#include <CQStrParse.h>
 #include <CQUtil.h>
 #include <QColor>
 #include <QFont>
+#include <QHash>
+#include <unordered_map>
+#include <shared_mutex>
+
+namespace {
+
+//! QString hash for parsed string cache
+struct NameValuesHash {
+  size_t operator()(const QString &str) const { return size_t(qHash(str)); }
+};
+
+//! true if character is trimmed by QString::trimmed
+bool isTrimChar(const QChar &c) {
+  return c.isSpace();
+}
+
+//! add name/value of word (unescaped) with position of first '=' (-1 if none)
+void addNameValue(const QString &word, int eqPos, CQModelNameValues::NameValues &nameValues) {
+  if (eqPos < 1) {
+    nameValues[word] = "1";
+    return;
+  }
+
+  // trim name and value in place (no intermediate strings)
+  int n1 = 0, n2 = eqPos;
+
+  while (n1 < n2 && isTrimChar(word[n1    ])) ++n1;
+  while (n2 > n1 && isTrimChar(word[n2 - 1])) --n2;
+
+  int v1 = eqPos + 1, v2 = word.length();
+
+  while (v1 < v2 && isTrimChar(word[v1    ])) ++v1;
+  while (v2 > v1 && isTrimChar(word[v2 - 1])) --v2;
+
+  nameValues[word.mid(n1, n2 - n1)] = word.mid(v1, v2 - v1);
+}
+
+}
+
+//---
 
 CQModelNameValues::
-CQModelNameValues()
+CQModelNameValues() :
+ parsed_(std::make_shared<Parsed>())
 {
 }
 
 CQModelNameValues::
-CQModelNameValues(const QString &str)
+CQModelNameValues(const QString &str) :
+ parsed_(parseCached(str))
 {
-  (void) fromString(str);
 }
 
 CQModelNameValues::
@@ -53,58 +93,170 @@ bool
 CQModelNameValues::
 fromString(const QString &str)
 {
-  NameValues nameValues;
-
-  if (! fromString(str, nameValues))
-    return false;
-
-  nameValues_ = nameValues;
+  parsed_ = parseCached(str);
 
   return true;
 }
 
 // <name>=<value>,...
+//
+// single pass over string characters: '\\' escapes next character, text in single
+// quotes is literal (except escapes) and ',' separates name value words.
 bool
 CQModelNameValues::
 fromString(const QString &str, NameValues &nameValues)
 {
-  if (! str.length())
+  int len = str.length();
+
+  if (! len)
     return true;
 
-  auto strs = splitNameValues(str);
+  const auto *chars = str.constData();
 
-  for (int i = 0; i < strs.length(); ++i) {
-    int pos1 = strs[i].indexOf("=");
+  QString word;
+
+  word.reserve(len);
+
+  int  eqPos     = -1;
+  bool in_quotes = false;
 
-    if (pos1 < 1) {
-      nameValues[strs[i]] = "1";
+  auto addChar = [&](const QChar &c) {
+    if (c == '=' && eqPos < 0)
+      eqPos = word.length();
+
+    word += c;
+  };
+
+  for (int i = 0; i < len; ++i) {
+    const auto &c = chars[i];
+
+    if      (c == '\\') {
+      if (i + 1 < len)
+        addChar(chars[++i]);
+    }
+    else if (c == '\'') {
+      in_quotes = ! in_quotes;
     }
-    else {
-      auto name  = strs[i].mid(0, pos1 ).trimmed();
-      auto value = strs[i].mid(pos1 + 1).trimmed();
+    else if (c == ',' && ! in_quotes) {
+      if (word.length())
+        addNameValue(word, eqPos, nameValues);
 
-      nameValues[name] = value;
+      word.resize(0);
+
+      eqPos = -1;
     }
+    else
+      addChar(c);
   }
 
+  if (word.length())
+    addNameValue(word, eqPos, nameValues);
+
+  return true;
+}
+
+CQModelNameValues::ParsedP
+CQModelNameValues::
+parseCached(const QString &str)
+{
+  // parsed values are shared by all name values created from the same string so
+  // repeated lookups (e.g. per cell column name values) do not re-parse
+  using ParsedMap = std::unordered_map<QString, ParsedP, NameValuesHash>;
+
+  static ParsedMap         parsedMap;
+  static std::shared_mutex parsedMutex;
+
+  static const size_t maxParsed = 4096;
+
+  {
+    std::shared_lock<std::shared_mutex> lock(parsedMutex);
+
+    auto p = parsedMap.find(str);
+
+    if (p != parsedMap.end())
+      return (*p).second;
+  }
+
+  auto parsed = std::make_shared<Parsed>();
+
+  (void) fromString(str, parsed->nameValues);
+
+  std::unique_lock<std::shared_mutex> lock(parsedMutex);
+
+  // bound cache size (old entries stay alive while referenced)
+  if (parsedMap.size() >= maxParsed)
+    parsedMap.clear();
+
+  auto pi = parsedMap.emplace(str, parsed);
+
+  return (*pi.first).second;
+}
+
+CQModelNameValues::NameValues &
+CQModelNameValues::
+modifyNameValues()
+{
+  // copy shared (cached) parse before modification
+  if (parsed_.use_count() > 1) {
+    auto parsed = std::make_shared<Parsed>();
+
+    parsed->nameValues = parsed_->nameValues;
+
+    parsed_ = parsed;
+  }
+  else {
+    std::unique_lock<std::mutex> lock(parsed_->mutex);
+
+    parsed_->typedValues.clear();
+  }
+
+  return parsed_->nameValues;
+}
+
+bool
+CQModelNameValues::
+typedValue(const QString &name, int type, QVariant &value) const
+{
+  std::unique_lock<std::mutex> lock(parsed_->mutex);
+
+  auto p = parsed_->typedValues.find(std::make_pair(name, type));
+
+  if (p == parsed_->typedValues.end())
+    return false;
+
+  value = (*p).second;
+
   return true;
 }
 
+void
+CQModelNameValues::
+setTypedValue(const QString &name, int type, const QVariant &value) const
+{
+  std::unique_lock<std::mutex> lock(parsed_->mutex);
+
+  parsed_->typedValues[std::make_pair(name, type)] = value;
+}
+
 bool
 CQModelNameValues::
 hasNameValue(const QString &name) const
 {
-  auto p = nameValues_.find(name);
-  return (p != nameValues_.end());
+  const auto &nameValues = this->nameValues();
+
+  auto p = nameValues.find(name);
+  return (p != nameValues.end());
 }
 
 bool
 CQModelNameValues::
 nameValue(const QString &name, QVariant &value) const
 {
-  auto p = nameValues_.find(name);
+  const auto &nameValues = this->nameValues();
+
+  auto p = nameValues.find(name);
 
-  if (p == nameValues_.end())
+  if (p == nameValues.end())
     return false;
 
   value = (*p).second;
@@ -120,17 +272,16 @@ setNameValue(const QString &name, const QVariant &value)
 {
   assert(value.isValid());
 
-  nameValues_[name] = value;
+  modifyNameValues()[name] = value;
 }
 
 void
 CQModelNameValues::
 removeName(const QString &name)
 {
-  auto p = nameValues_.find(name);
-  if (p == nameValues_.end()) return;
+  if (! hasNameValue(name)) return;
 
-  nameValues_.erase(p);
+  modifyNameValues().erase(name);
 }
 
 bool
@@ -157,15 +308,21 @@ nameValueInteger(const QString &name, long &value, bool &ok) const
 
   QVariant var;
 
+  if (typedValue(name, QVariant::LongLong, var)) {
+    ok    = var.isValid();
+    value = (ok ? long(var.value<qlonglong>()) : 0);
+    return true;
+  }
+
   if (! nameValue(name, var))
     return false;
 
-  if (var.type() == QVariant::LongLong) {
+  if (var.type() == QVariant::LongLong)
     value = var.value<qlonglong>();
-    return true;
-  }
+  else
+    value = var.toInt(&ok);
 
-  value = var.toInt(&ok);
+  setTypedValue(name, QVariant::LongLong, ok ? QVariant(qlonglong(value)) : QVariant());
 
   return true;
 }
@@ -178,11 +335,19 @@ nameValueReal(const QString &name, double &value, bool &ok) const
 
   QVariant var;
 
+  if (typedValue(name, QVariant::Double, var)) {
+    ok    = var.isValid();
+    value = (ok ? var.toDouble() : 0.0);
+    return true;
+  }
+
   if (! nameValue(name, var))
     return false;
 
   value = var.toDouble(&ok);
 
+  setTypedValue(name, QVariant::Double, ok ? QVariant(value) : QVariant());
+
   return true;
 }
 
@@ -210,6 +375,12 @@ nameValueColor(const QString &name, QColor &color, bool &ok) const
 
   QVariant var;
 
+  if (typedValue(name, QVariant::Color, var)) {
+    color = var.value<QColor>();
+    ok    = color.isValid();
+    return true;
+  }
+
   if (! nameValue(name, var))
     return false;
 
@@ -220,6 +391,8 @@ nameValueColor(const QString &name, QColor &color, bool &ok) const
 
   ok = color.isValid();
 
+  setTypedValue(name, QVariant::Color, color);
+
   return true;
 }
 
@@ -231,6 +404,11 @@ nameValueFont(const QString &name, QFont &font, bool &ok) const
 
   QVariant var;
 
+  if (typedValue(name, QVariant::Font, var)) {
+    font = var.value<QFont>();
+    return true;
+  }
+
   if (! nameValue(name, var))
     return false;
 
@@ -239,6 +417,8 @@ nameValueFont(const QString &name, QFont &font, bool &ok) const
   else
     font = QFont(var.toString());
 
+  setTypedValue(name, QVariant::Font, font);
+
   return true;
 }
 
@@ -248,70 +428,25 @@ nameValueAlign(const QString &name, Qt::Alignment &align, bool &ok) const
 {
   QVariant var;
 
-  if (! nameValue(name, var))
-    return false;
-
-  if (! CQUtil::stringToAlign(var.toString(), align))
-    ok = false;
+  if (typedValue(name, QVariant::Int, var)) {
+    if (var.isValid())
+      align = Qt::Alignment(var.toInt());
+    else
+      ok = false;
 
-  return true;
-}
-
-QStringList
-CQModelNameValues::
-splitNameValues(const QString &str)
-{
-  QStringList words;
-
-  CQStrParse parse(str);
+    return true;
+  }
 
-  QString word;
+  if (! nameValue(name, var))
+    return false;
 
-  bool in_quotes = false;
+  if (CQUtil::stringToAlign(var.toString(), align))
+    setTypedValue(name, QVariant::Int, int(align));
+  else {
+    setTypedValue(name, QVariant::Int, QVariant());
 
-  while (! parse.eof()) {
-    if (! in_quotes) {
-      if      (parse.isChar('\\')) {
-        parse.skipChar();
-
-        if (! parse.eof())
-          word += parse.getChar();
-      }
-      else if (parse.isChar('\'')) {
-        parse.skipChar();
-
-        in_quotes = true;
-      }
-      else if (parse.isChar(',')) {
-        parse.skipChar();
-
-        if (word.length())
-          words.push_back(word);
-
-        word = "";
-      }
-      else
-        word += parse.getChar();
-    }
-    else {
-      if     (parse.isChar('\\')) {
-        parse.skipChar();
-
-        if (! parse.eof())
-          word += parse.getChar();
-      }
-      else if (parse.isChar('\'')) {
-        parse.skipChar();
-
-        in_quotes = false;
-      }
-      else
-        word += parse.getChar();
-    }
+    ok = false;
   }
 
-  if (word.length())
-    words.push_back(word);
-
-  return words;
+  return true;
 }
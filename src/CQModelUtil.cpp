@@ -1,13 +1,22 @@
 #include <CQModelUtil.h>
 #include <CQModelVisitor.h>
 #include <CQBaseModel.h>
+#include <CQDataModel.h>
 #include <CQAlignVariant.h>
 
 #include <CMathUtil.h>
 
 #include <QSortFilterProxyModel>
+#include <QDataStream>
 #include <QColor>
 
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <shared_mutex>
+#include <typeindex>
+#include <unordered_map>
+
 namespace CQModelUtil {
 
 int
@@ -173,6 +182,63 @@ modelConvInteger(const QAbstractItemModel *model, const QModelIndex &ind, bool &
   return i;
 }
 
+bool
+isIntegerVariant(const QVariant &var)
+{
+  bool ok = true;
+
+  if      (var.type() == QVariant::LongLong)
+    return true;
+  else if (var.type() == QVariant::Double) {
+    double r = var.toDouble(&ok);
+
+    if (std::abs(r - std::round(r)) > 1E-6)
+      ok = false;
+  }
+  else
+    (void) var.toLongLong(&ok);
+
+  return ok;
+}
+
+QString
+variantKey(const QVariant &var)
+{
+  switch (var.type()) {
+    case QVariant::Invalid:
+      return QString();
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      return "n:" + var.toString();
+    case QVariant::Double: {
+      double r = var.toDouble();
+
+      // integral reals use integer key so equal to integer value
+      if (std::abs(r) < 1E15 && r == std::round(r))
+        return "n:" + QString::number(qlonglong(r));
+
+      return "n:" + QString::number(r, 'g', 17);
+    }
+    case QVariant::String:
+      return "s:" + var.toString();
+    default:
+      break;
+  }
+
+  if (var.canConvert<QString>())
+    return QString(var.typeName()) + ":" + var.toString();
+
+  QByteArray ba;
+
+  QDataStream ds(&ba, QIODevice::WriteOnly);
+
+  ds << var;
+
+  return QString(var.typeName()) + ":" + QString::fromLatin1(ba.toBase64().constData());
+}
+
 long
 modelInteger(const QAbstractItemModel *model, const QModelIndex &ind, bool &ok)
 {
@@ -222,37 +288,81 @@ columnValueType(const QAbstractItemModel *model, int c, CQBaseModelType &type)
 
 CQBaseModelType
 calcColumnType(const QAbstractItemModel *model, int icolumn, int maxRows)
+{
+  ColumnTypeSample sample;
+
+  sample.type    = CQBaseModelTypeSample::HEAD;
+  sample.maxRows = maxRows;
+
+  return calcColumnType(model, icolumn, sample);
+}
+
+CQBaseModelType
+calcColumnType(const QAbstractItemModel *model, int icolumn, const ColumnTypeSample &sample,
+               bool *complete)
 {
   //CQPerfTrace trace("CQUtil::calcColumnType");
 
   // determine column type from values
 
+  using Clock = std::chrono::steady_clock;
+
   // process model data
   class ColumnTypeVisitor : public CQModelVisitor {
    public:
-    ColumnTypeVisitor(int column) :
-     column_(column) {
+    ColumnTypeVisitor(int column, int role=-1, long maxTime=-1,
+                      const std::atomic<bool> *cancel=nullptr) :
+     column_(column), role_(role), maxTime_(maxTime), cancel_(cancel) {
     }
 
     void initVisit() override {
       nr_ = model_->rowCount(QModelIndex());
+
+      startTime_ = Clock::now();
     }
 
     State visit(const QAbstractItemModel *model, const VisitData &data) override {
-      auto ind = model->index(data.row, column_, data.parent);
+      // check time budget and cancel every 256 rows
+      if ((numTested_ & 0xff) == 0xff) {
+        if (cancel_ && *cancel_) {
+          timedOut_ = true;
+          return State::TERMINATE;
+        }
 
-      // if column can be integral, check if value is valid integer
-      if (isInt_) {
-        bool ok;
+        if (maxTime_ > 0) {
+          auto dt = std::chrono::duration_cast<std::chrono::microseconds>(
+                      Clock::now() - startTime_).count();
 
-        (void) modelConvInteger(model, ind, ok);
+          if (dt > maxTime_) {
+            timedOut_ = true;
+            return State::TERMINATE;
+          }
+        }
+      }
 
-        if (ok)
-          return State::SKIP;
+      return testRow(model, data.row, data.parent);
+    }
 
-        auto str = modelString(model, ind, ok);
+    State testRow(const QAbstractItemModel *model, int row, const QModelIndex &parent) {
+      auto ind = model->index(row, column_, parent);
+
+      ++numTested_;
+
+      // get value once and test conversions
+      bool ok;
+
+      auto var = (role_ >= 0 ? modelValue(model, ind, role_, ok) : modelValue(model, ind, ok));
+
+      auto isEmpty = [&]() {
+        return (! ok || ! var.toString().length());
+      };
+
+      // if column can be integral, check if value is valid integer
+      if (isInt_) {
+        if (ok && isIntegerVariant(var))
+          return State::SKIP;
 
-        if (! str.length()) { // empty
+        if (isEmpty()) {
           ++numEmpty_;
           return State::SKIP;
         }
@@ -262,16 +372,15 @@ calcColumnType(const QAbstractItemModel *model, int icolumn, int maxRows)
 
       // if column can be real, check if value is valid real
       if (isReal_) {
-        bool ok;
-
-        (void) modelReal(model, ind, ok);
+        bool ok1 = false;
 
         if (ok)
-          return State::SKIP;
+          (void) var.toDouble(&ok1);
 
-        auto str = modelString(model, ind, ok);
+        if (ok1)
+          return State::SKIP;
 
-        if (! str.length()) { // empty
+        if (isEmpty()) {
           ++numEmpty_;
           return State::SKIP;
         }
@@ -283,8 +392,29 @@ calcColumnType(const QAbstractItemModel *model, int icolumn, int maxRows)
       return State::TERMINATE;
     }
 
+    CQModelVisitor *clone() const override {
+      return new ColumnTypeVisitor(column_, role_, maxTime_, cancel_);
+    }
+
+    void merge(const CQModelVisitor &visitor) override {
+      const auto &typeVisitor = static_cast<const ColumnTypeVisitor &>(visitor);
+
+      isInt_     = isInt_  && typeVisitor.isInt_;
+      isReal_    = isReal_ && typeVisitor.isReal_;
+      numEmpty_  += typeVisitor.numEmpty_;
+      numTested_ += typeVisitor.numTested_;
+      timedOut_  = timedOut_ || typeVisitor.timedOut_;
+    }
+
+    bool isString() const { return (! isInt_ && ! isReal_); }
+
+    bool isTimedOut() const { return timedOut_; }
+
+    int numTested() const { return numTested_; }
+
     CQBaseModelType columnType() {
-      if (numEmpty_ == nr_ || (nr_ > maxRows_ && numEmpty_ == maxRows_))
+      // all tested values empty
+      if (numEmpty_ == numTested_)
         return CQBaseModelType::STRING;
 
       if      (isInt_ ) return CQBaseModelType::INTEGER;
@@ -293,20 +423,70 @@ calcColumnType(const QAbstractItemModel *model, int icolumn, int maxRows)
     }
 
    private:
-    int  column_   { -1 };   //!< column to check
-    bool isInt_    { true }; //!< could be integeral
-    bool isReal_   { true }; //!< could be real
-    int  nr_       { 0 };    //!< number of rows
-    int  numEmpty_ { 0 };    //!< number of empty values
+    int                      column_    { -1 };      //!< column to check
+    int                      role_      { -1 };      //!< value role (-1 edit then display)
+    long                     maxTime_   { -1 };      //!< max time (microseconds)
+    const std::atomic<bool>* cancel_    { nullptr }; //!< cancel flag
+    bool                     isInt_     { true };    //!< could be integeral
+    bool                     isReal_    { true };    //!< could be real
+    int                      nr_        { 0 };       //!< number of rows
+    int                      numEmpty_  { 0 };       //!< number of empty values
+    int                      numTested_ { 0 };       //!< number of tested values
+    bool                     timedOut_  { false };   //!< time budget exceeded or cancelled
+    Clock::time_point        startTime_;             //!< visit start time
   };
 
   // determine column value type by looking at model values
-  ColumnTypeVisitor columnTypeVisitor(icolumn);
+  ColumnTypeVisitor columnTypeVisitor(icolumn, sample.role, sample.maxTime, sample.cancel);
+
+  int nr = model->rowCount(QModelIndex());
+
+  auto sampleType = sample.type;
 
-  if (maxRows > 0)
-    columnTypeVisitor.setNumRows(maxRows);
+  if (sampleType != CQBaseModelTypeSample::FULL && (sample.maxRows <= 0 || sample.maxRows >= nr))
+    sampleType = CQBaseModelTypeSample::FULL;
 
-  CQModelVisit::exec(model, columnTypeVisitor);
+  // stratified sample of flat model: test random row from each of maxRows row ranges
+  if (sampleType == CQBaseModelTypeSample::STRATIFIED && ! isHierarchical(model)) {
+    columnTypeVisitor.init(model);
+
+    std::mt19937 gen(static_cast<uint>(icolumn));
+
+    double dr = double(nr)/sample.maxRows;
+
+    QModelIndex parent;
+
+    for (int i = 0; i < sample.maxRows; ++i) {
+      int r1 = int(i*dr);
+      int r2 = std::max(int((i + 1)*dr), r1 + 1);
+
+      std::uniform_int_distribution<int> dist(r1, r2 - 1);
+
+      auto state = columnTypeVisitor.visit(model, CQModelVisitor::VisitData(parent, dist(gen)));
+
+      if (state == CQModelVisitor::State::TERMINATE)
+        break;
+    }
+
+    columnTypeVisitor.term();
+  }
+  else {
+    // head sample (first rows) or full scan
+    if (sampleType != CQBaseModelTypeSample::FULL)
+      columnTypeVisitor.setMaxRows(sample.maxRows);
+
+    // data model values can be read from multiple threads so scan in parallel
+    // (unless already on a worker thread)
+    if (! sample.serial && dynamic_cast<const CQDataModel *>(model))
+      CQModelVisit::execParallel(model, columnTypeVisitor);
+    else
+      CQModelVisit::exec(model, columnTypeVisitor);
+  }
+
+  // type can only be promoted (integer -> real -> string) by untested values
+  if (complete)
+    *complete = (columnTypeVisitor.isString() ||
+                 (sampleType == CQBaseModelTypeSample::FULL && ! columnTypeVisitor.isTimedOut()));
 
   return columnTypeVisitor.columnType();
 }
@@ -331,60 +511,65 @@ getBaseModel(QAbstractItemModel *model)
 
 //------
 
-using RoleData        = CQBaseModel::RoleData;
-using RoleDatas       = std::vector<RoleData>;
-using NameRoleMap     = std::map<QString, int>;
-using RoleNameMap     = std::map<int, QString>;
-using NameStandardMap = std::map<QString, bool>;
-using NameWritableMap = std::map<QString, bool>;
-using NameTypeMap     = std::map<QString, QVariant::Type>;
-
-static RoleDatas       s_roleNames;
-static RoleNameMap     s_roleNameMap;
-static NameRoleMap     s_nameRoleMap;
-static NameStandardMap s_nameStandardMap;
-static NameWritableMap s_nameWritableMap;
-static NameTypeMap     s_nameTypeMap;
-
-static std::map<Qt::Orientation, RoleDatas>       s_headerRoleDatas;
-static std::map<Qt::Orientation, RoleNameMap>     s_headerRoleNameMap;
-static std::map<Qt::Orientation, NameRoleMap>     s_headerNameRoleMap;
-static std::map<Qt::Orientation, NameTypeMap>     s_headerNameTypeMap;
-static std::map<Qt::Orientation, NameWritableMap> s_headerNameWritableMap;
-
-bool
-initRoles(const QAbstractItemModel *model)
-{
-  static QAbstractItemModel *s_model;
+using RoleData  = CQBaseModel::RoleData;
+using RoleDatas = std::vector<RoleData>;
 
-  if (s_model != model)
-    s_roleNames.clear();
-
-  if (! s_roleNames.empty())
-    return false;
-
-  //---
+struct RoleNameHash {
+  size_t operator()(const QString &s) const { return qHash(s); }
+};
 
-  s_model = const_cast<QAbstractItemModel *>(model);
+using NameRoleMap     = std::unordered_map<QString, int, RoleNameHash>;
+using RoleNameMap     = std::unordered_map<int, QString>;
+using NameStandardMap = std::unordered_map<QString, bool, RoleNameHash>;
+using NameWritableMap = std::unordered_map<QString, bool, RoleNameHash>;
+using NameTypeMap     = std::unordered_map<QString, QVariant::Type, RoleNameHash>;
+
+//! role names and lookups for orientation header
+struct HeaderRoles {
+  RoleDatas       roleDatas;       //!< header role datas
+  QStringList     names;           //!< header role names
+  RoleNameMap     roleNameMap;     //!< role to name
+  NameRoleMap     nameRoleMap;     //!< name to role
+  NameTypeMap     nameTypeMap;     //!< name to type
+  NameWritableMap nameWritableMap; //!< name to writable
+};
 
-  s_nameRoleMap    .clear();
-  s_nameStandardMap.clear();
-  s_nameTypeMap    .clear();
+//! role names and lookups for model class (built once, read only after)
+struct RoleRegistry {
+  RoleDatas       roleDatas;       //!< role datas
+  QStringList     names;           //!< role names
+  RoleNameMap     roleNameMap;     //!< role to name
+  NameRoleMap     nameRoleMap;     //!< name to role
+  NameStandardMap nameStandardMap; //!< name to standard
+  NameWritableMap nameWritableMap; //!< name to writable
+  NameTypeMap     nameTypeMap;     //!< name to type
+  HeaderRoles     hheaderRoles;    //!< horizontal header roles
+  HeaderRoles     vheaderRoles;    //!< vertical header roles
+
+  const HeaderRoles &headerRoles(Qt::Orientation orient) const {
+    return (orient == Qt::Horizontal ? hheaderRoles : vheaderRoles);
+  }
+};
 
+static void
+initRoleRegistry(const QAbstractItemModel *model, RoleRegistry &registry)
+{
 //using Standard = CQBaseModel::Standard;
   using Writable = CQBaseModel::Writable;
 
   auto addRole = [&](const RoleData &data, bool alias=false) {
     if (! alias) {
-      s_roleNames.push_back(data);
+      registry.roleDatas.push_back(data);
 
-      s_roleNameMap[data.role] = data.name;
+      registry.names << data.name;
+
+      registry.roleNameMap[data.role] = data.name;
     }
 
-    s_nameRoleMap    [data.name] = data.role;
-    s_nameStandardMap[data.name] = data.standard;
-    s_nameWritableMap[data.name] = data.writable;
-    s_nameTypeMap    [data.name] = data.type;
+    registry.nameRoleMap    [data.name] = data.role;
+    registry.nameStandardMap[data.name] = data.standard;
+    registry.nameWritableMap[data.name] = data.writable;
+    registry.nameTypeMap    [data.name] = data.type;
   };
 
   auto addStandardRole = [&](const QString &name, int role,
@@ -430,13 +615,18 @@ initRoles(const QAbstractItemModel *model)
   //---
 
   auto addHeaderRoleData = [&](Qt::Orientation orient, const RoleData &data) {
-    s_headerRoleDatas[orient].push_back(data);
+    auto &headerRoles = (orient == Qt::Horizontal ? registry.hheaderRoles :
+                                                    registry.vheaderRoles);
+
+    headerRoles.roleDatas.push_back(data);
+
+    headerRoles.names << data.name;
 
-    s_headerRoleNameMap[orient][data.role] = data.name;
+    headerRoles.roleNameMap[data.role] = data.name;
 
-    s_headerNameRoleMap    [orient][data.name] = data.role;
-    s_headerNameWritableMap[orient][data.name] = data.writable;
-    s_headerNameTypeMap    [orient][data.name] = data.type;
+    headerRoles.nameRoleMap    [data.name] = data.role;
+    headerRoles.nameWritableMap[data.name] = data.writable;
+    headerRoles.nameTypeMap    [data.name] = data.type;
   };
 
   auto addHHeaderRole = [&](const QString &name, int role,
@@ -474,34 +664,61 @@ initRoles(const QAbstractItemModel *model)
 #endif
 
   addVHeaderRole("display", Qt::DisplayRole);
-
-  return true;
 }
 
-const QStringList &
-roleNames(QAbstractItemModel *model)
+// get role registry for model class (roles only depend on class so built once per class)
+static const RoleRegistry &
+getRoleRegistry(const QAbstractItemModel *model)
 {
-  static QStringList s_names;
+  using RoleRegistryP  = std::unique_ptr<RoleRegistry>;
+  using RoleRegistries = std::unordered_map<std::type_index, RoleRegistryP>;
+
+  static RoleRegistries    s_registries;
+  static std::shared_mutex s_mutex;
+
+  auto key = (model ? std::type_index(typeid(*model)) :
+                      std::type_index(typeid(QAbstractItemModel)));
+
+  {
+  std::shared_lock<std::shared_mutex> lock(s_mutex);
 
-  if (initRoles(model))
-    s_names.clear();
+  auto p = s_registries.find(key);
 
-  if (s_names.empty()) {
-    for (const auto &roleName : s_roleNames)
-      s_names << roleName.name;
+  if (p != s_registries.end())
+    return *(*p).second;
   }
 
-  return s_names;
+  //---
+
+  // build outside lock (first registry added wins)
+  auto registry = std::make_unique<RoleRegistry>();
+
+  initRoleRegistry(model, *registry);
+
+  std::unique_lock<std::shared_mutex> lock(s_mutex);
+
+  auto p = s_registries.find(key);
+
+  if (p == s_registries.end())
+    p = s_registries.emplace(key, std::move(registry)).first;
+
+  return *(*p).second;
+}
+
+const QStringList &
+roleNames(QAbstractItemModel *model)
+{
+  return getRoleRegistry(model).names;
 };
 
 int
 nameToRole(QAbstractItemModel *model, const QString &name)
 {
-  (void) initRoles(model);
+  const auto &registry = getRoleRegistry(model);
 
-  auto p = s_nameRoleMap.find(name);
+  auto p = registry.nameRoleMap.find(name);
 
-  if (p != s_nameRoleMap.end())
+  if (p != registry.nameRoleMap.end())
     return (*p).second;
 
   bool ok;
@@ -515,11 +732,11 @@ nameToRole(QAbstractItemModel *model, const QString &name)
 QString
 roleToName(QAbstractItemModel *model, int role)
 {
-  (void) initRoles(model);
+  const auto &registry = getRoleRegistry(model);
 
-  auto p = s_roleNameMap.find(role);
+  auto p = registry.roleNameMap.find(role);
 
-  if (p != s_roleNameMap.end())
+  if (p != registry.roleNameMap.end())
     return (*p).second;
 
   return QString::number(role);
@@ -528,11 +745,11 @@ roleToName(QAbstractItemModel *model, int role)
 bool
 nameIsStandard(QAbstractItemModel *model, const QString &name)
 {
-  (void) initRoles(model);
+  const auto &registry = getRoleRegistry(model);
 
-  auto p = s_nameStandardMap.find(name);
+  auto p = registry.nameStandardMap.find(name);
 
-  if (p != s_nameStandardMap.end())
+  if (p != registry.nameStandardMap.end())
     return (*p).second;
 
   return false;
@@ -541,11 +758,11 @@ nameIsStandard(QAbstractItemModel *model, const QString &name)
 bool
 nameIsWritable(QAbstractItemModel *model, const QString &name)
 {
-  (void) initRoles(model);
+  const auto &registry = getRoleRegistry(model);
 
-  auto p = s_nameWritableMap.find(name);
+  auto p = registry.nameWritableMap.find(name);
 
-  if (p != s_nameWritableMap.end())
+  if (p != registry.nameWritableMap.end())
     return (*p).second;
 
   return false;
@@ -554,11 +771,11 @@ nameIsWritable(QAbstractItemModel *model, const QString &name)
 QVariant::Type
 nameType(QAbstractItemModel *model, const QString &name)
 {
-  (void) initRoles(model);
+  const auto &registry = getRoleRegistry(model);
 
-  auto p = s_nameTypeMap.find(name);
+  auto p = registry.nameTypeMap.find(name);
 
-  if (p != s_nameTypeMap.end())
+  if (p != registry.nameTypeMap.end())
     return (*p).second;
 
   return QVariant::Invalid;
@@ -569,27 +786,13 @@ nameType(QAbstractItemModel *model, const QString &name)
 const QStringList &
 headerRoleNames(QAbstractItemModel *model, Qt::Orientation orient)
 {
-  static QStringList s_names;
-
-  if (initRoles(model))
-    s_names.clear();
-
-  if (s_names.empty()) {
-    const auto &headerRoleDatas = s_headerRoleDatas[orient];
-
-    for (const auto &roleName : headerRoleDatas)
-      s_names << roleName.name;
-  }
-
-  return s_names;
+  return getRoleRegistry(model).headerRoles(orient).names;
 };
 
 int
 headerNameToRole(QAbstractItemModel *model, Qt::Orientation orient, const QString &name)
 {
-  (void) initRoles(model);
-
-  const auto &headerNameRoleMap = s_headerNameRoleMap[orient];
+  const auto &headerNameRoleMap = getRoleRegistry(model).headerRoles(orient).nameRoleMap;
 
   auto p = headerNameRoleMap.find(name);
 
@@ -607,9 +810,7 @@ headerNameToRole(QAbstractItemModel *model, Qt::Orientation orient, const QStrin
 QString
 headerRoleToName(QAbstractItemModel *model, Qt::Orientation orient, int role)
 {
-  (void) initRoles(model);
-
-  const auto &headerRoleNameMap = s_headerRoleNameMap[orient];
+  const auto &headerRoleNameMap = getRoleRegistry(model).headerRoles(orient).roleNameMap;
 
   auto p = headerRoleNameMap.find(role);
 
@@ -622,9 +823,7 @@ headerRoleToName(QAbstractItemModel *model, Qt::Orientation orient, int role)
 QVariant::Type
 headerNameType(QAbstractItemModel *model, Qt::Orientation orient, const QString &name)
 {
-  (void) initRoles(model);
-
-  const auto &headerNameTypeMap = s_headerNameTypeMap[orient];
+  const auto &headerNameTypeMap = getRoleRegistry(model).headerRoles(orient).nameTypeMap;
 
   auto p = headerNameTypeMap.find(name);
 
@@ -637,9 +836,8 @@ headerNameType(QAbstractItemModel *model, Qt::Orientation orient, const QString
 bool
 headerNameIsWritable(QAbstractItemModel *model, Qt::Orientation orient, const QString &name)
 {
-  (void) initRoles(model);
-
-  const auto &headerNameWritableMap = s_headerNameWritableMap[orient];
+  const auto &headerNameWritableMap =
+    getRoleRegistry(model).headerRoles(orient).nameWritableMap;
 
   auto p = headerNameWritableMap.find(name);
 
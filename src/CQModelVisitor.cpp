@@ -1,5 +1,11 @@
 #include <CQModelVisitor.h>
 #include <CQModelUtil.h>
+#include <CQBaseModel.h>
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
 
 void
 CQModelVisitor::
@@ -78,6 +84,253 @@ bool exec(const QAbstractItemModel *model, const QModelIndex &parent,
   return true;
 }
 
+bool execParallel(const QAbstractItemModel *model, CQModelVisitor &visitor, int numThreads)
+{
+  if (! model)
+    return false;
+
+  visitor.init(model);
+
+  QModelIndex parent;
+
+  int nr = model->rowCount(parent);
+
+  // split rows into ranges of at least minChunkRows for each thread
+  const int minChunkRows = 4096;
+
+  if (numThreads <= 0)
+    numThreads = int(std::thread::hardware_concurrency());
+
+  numThreads = std::max(std::min(numThreads, nr/minChunkRows), 1);
+
+  //---
+
+  using VisitorP = std::unique_ptr<CQModelVisitor>;
+
+  std::vector<VisitorP> workers;
+
+  if (numThreads > 1 && visitor.maxRows() <= 0 && ! visitor.isHierarchical()) {
+    for (int i = 0; i < numThreads; ++i) {
+      VisitorP worker(visitor.clone());
+      if (! worker) { workers.clear(); break; }
+
+      workers.push_back(std::move(worker));
+    }
+  }
+
+  // sequential fallback
+  if (workers.empty()) {
+    (void) execIndex(model, parent, visitor);
+
+    visitor.term();
+
+    return true;
+  }
+
+  //---
+
+  int chunkRows = (nr + numThreads - 1)/numThreads;
+
+  // first row returning terminate (rows before it must still be visited by all workers)
+  std::atomic<int> terminateRow { nr };
+
+  auto visitRows = [&](CQModelVisitor *worker, int r1, int r2) {
+    worker->init(model);
+
+    worker->setNumRows(nr);
+    worker->setRow    (r1);
+
+    for (int row = r1; row < r2; ++row) {
+      if (row > terminateRow)
+        break;
+
+      auto state = execRow(model, parent, row, *worker);
+
+      if (state == CQModelVisitor::State::TERMINATE) {
+        int terminateRow1 = terminateRow;
+
+        while (row < terminateRow1 &&
+               ! terminateRow.compare_exchange_weak(terminateRow1, row)) {
+        }
+
+        break;
+      }
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+
+  for (int i = 0; i < numThreads; ++i) {
+    int r1 = i*chunkRows;
+    int r2 = std::min(r1 + chunkRows, nr);
+
+    futures.push_back(std::async(std::launch::async, visitRows, workers[size_t(i)].get(), r1, r2));
+  }
+
+  for (auto &future : futures)
+    future.get();
+
+  //---
+
+  // merge worker results in row order (workers starting after terminate row are dropped
+  // as sequential visit would not reach their rows)
+  int numProcessed = 0;
+
+  for (int i = 0; i < numThreads; ++i) {
+    if (i*chunkRows > terminateRow)
+      break;
+
+    auto *worker = workers[size_t(i)].get();
+
+    worker->term();
+
+    visitor.merge(*worker);
+
+    numProcessed += worker->row() - i*chunkRows;
+  }
+
+  visitor.setNumRows(nr);
+  visitor.setRow    (numProcessed);
+
+  visitor.term();
+
+  return true;
+}
+
+bool execBlocks(const QAbstractItemModel *model, CQModelBlockVisitor &visitor)
+{
+  if (! model)
+    return false;
+
+  if (CQModelUtil::isHierarchical(model))
+    return false;
+
+  visitor.initVisit(model);
+
+  //---
+
+  using ValueType    = CQModelBlockVisitor::ValueType;
+  using ColumnValues = CQModelBlockVisitor::ColumnValues;
+
+  const auto *baseModel = (visitor.isRawValues() ?
+    qobject_cast<const CQBaseModel *>(model) : nullptr);
+
+  QModelIndex parent;
+
+  int nr = model->rowCount(parent);
+  int nc = model->columnCount(parent);
+
+  const auto &blockColumns = visitor.blockColumns();
+
+  CQModelBlockVisitor::Block block;
+
+  block.columns.resize(blockColumns.size());
+
+  std::vector<QVariant> vars;
+
+  // convert variant to column type
+  auto setValue = [](ColumnValues &values, size_t i, const QVariant &var) {
+    bool ok = var.isValid();
+
+    switch (values.type) {
+      case ValueType::REAL: {
+        values.reals[i] = (ok ? var.toDouble(&ok) : 0.0);
+        break;
+      }
+      case ValueType::INTEGER: {
+        long l = 0;
+
+        if (ok) {
+          if      (var.type() == QVariant::LongLong)
+            l = var.value<qlonglong>();
+          else if (var.type() == QVariant::Double) {
+            double r = var.toDouble(&ok);
+
+            if (std::abs(r - std::round(r)) > 1E-6)
+              ok = false;
+            else
+              l = long(std::round(r));
+          }
+          else
+            l = long(var.toLongLong(&ok));
+        }
+
+        values.integers[i] = l;
+
+        break;
+      }
+      case ValueType::STRING: {
+        values.strings[i] = (ok ? var.toString() : QString());
+        break;
+      }
+      default: {
+        values.variants[i] = var;
+        break;
+      }
+    }
+
+    values.valid[i] = (ok ? 1 : 0);
+  };
+
+  for (int row = 0; row < nr; row += visitor.blockSize()) {
+    int n = std::min(visitor.blockSize(), nr - row);
+
+    block.row     = row;
+    block.numRows = n;
+
+    for (size_t ic = 0; ic < blockColumns.size(); ++ic) {
+      const auto &blockColumn = blockColumns[ic];
+
+      auto &values = block.columns[ic];
+
+      values.column = blockColumn.column;
+      values.type   = blockColumn.type;
+
+      auto n1 = size_t(n);
+
+      values.valid.resize(n1);
+
+      switch (values.type) {
+        case ValueType::REAL   : values.reals   .resize(n1); break;
+        case ValueType::INTEGER: values.integers.resize(n1); break;
+        case ValueType::STRING : values.strings .resize(n1); break;
+        default                : values.variants.resize(n1); break;
+      }
+
+      if (blockColumn.column < 0 || blockColumn.column >= nc) {
+        for (size_t i = 0; i < n1; ++i)
+          setValue(values, i, QVariant());
+
+        continue;
+      }
+
+      // fast path for models supporting raw column values
+      if (baseModel && baseModel->getRawColumnValues(blockColumn.column, row, n, vars)) {
+        for (size_t i = 0; i < n1; ++i)
+          setValue(values, i, vars[i]);
+      }
+      else {
+        for (int i = 0; i < n; ++i) {
+          bool ok;
+
+          auto var = CQModelUtil::modelValue(model, row + i, blockColumn.column, parent, ok);
+
+          setValue(values, size_t(i), var);
+        }
+      }
+    }
+
+    auto state = visitor.visitBlock(model, block);
+
+    if (state == CQModelVisitor::State::TERMINATE)
+      break;
+  }
+
+  visitor.termVisit();
+
+  return true;
+}
+
 CQModelVisitor::State
 execIndex(const QAbstractItemModel *model, const QModelIndex &parent, CQModelVisitor &visitor)
 {
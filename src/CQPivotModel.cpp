@@ -0,0 +1,556 @@
+#include <CQPivotModel.h>
+#include <CQModelUtil.h>
+
+CQPivotModel::
+CQPivotModel(QAbstractItemModel *sourceModel, const Columns &keyColumns,
+             const Aggregates &aggregates) :
+ CQDataModel(int(keyColumns.size() + aggregates.size()), 0),
+ sourceModel_(sourceModel), keyColumns_(keyColumns), aggregates_(aggregates)
+{
+  setObjectName("pivotModel");
+
+  setDataType(DATA_TYPE_PIVOT);
+
+  setReadOnly(true);
+
+  //---
+
+  connect(sourceModel_, SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)),
+          this, SLOT(sourceDataChanged(const QModelIndex &, const QModelIndex &)));
+  connect(sourceModel_, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+          this, SLOT(sourceRowsInserted(const QModelIndex &, int, int)));
+  connect(sourceModel_, SIGNAL(rowsRemoved(const QModelIndex &, int, int)),
+          this, SLOT(sourceRowsRemoved(const QModelIndex &, int, int)));
+  connect(sourceModel_, SIGNAL(rowsMoved(const QModelIndex &, int, int,
+                                         const QModelIndex &, int)),
+          this, SLOT(sourceReset()));
+  connect(sourceModel_, SIGNAL(layoutChanged()), this, SLOT(sourceReset()));
+  connect(sourceModel_, SIGNAL(modelReset()), this, SLOT(sourceReset()));
+
+  //---
+
+  initHeader();
+
+  rebuild();
+}
+
+CQPivotModel::
+~CQPivotModel()
+{
+}
+
+void
+CQPivotModel::
+initHeader()
+{
+  CQModelGroupBy groupBy(sourceModel_);
+
+  int nk = int(keyColumns_.size());
+  int na = int(aggregates_.size());
+
+  for (int c = 0; c < nk; ++c) {
+    bool ok;
+
+    hheader_[size_t(c)] = CQModelUtil::modelHeaderString(sourceModel_, keyColumns_[size_t(c)], ok);
+  }
+
+  for (int c = 0; c < na; ++c) {
+    const auto &aggregate = aggregates_[size_t(c)];
+
+    hheader_[size_t(nk + c)] = groupBy.aggregateName(aggregate);
+
+    if (aggregate.type == AggregateType::COUNT)
+      setColumnType(nk + c, CQBaseModelType::INTEGER);
+    else
+      setColumnType(nk + c, CQBaseModelType::REAL);
+  }
+}
+
+void
+CQPivotModel::
+rebuild()
+{
+  beginResetModel();
+
+  sourceRowDatas_.clear();
+  groupDatas_    .clear();
+  groupRows_     .clear();
+
+  data_.clear();
+
+  clearCachedColumn();
+
+  //---
+
+  int nr = sourceModel_->rowCount();
+
+  sourceRowDatas_.resize(size_t(nr));
+
+  Rows changedRows;
+
+  for (int r = 0; r < nr; ++r) {
+    auto &rowData = sourceRowDatas_[size_t(r)];
+
+    calcRowData(r, rowData);
+
+    addRowData(rowData, changedRows, /*notify*/false);
+  }
+
+  for (int r = 0; r < int(groupDatas_.size()); ++r)
+    updateGroupRow(r);
+
+  endResetModel();
+}
+
+void
+CQPivotModel::
+sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+  if (topLeft.parent().isValid())
+    return;
+
+  int r1 = topLeft.row(), r2 = bottomRight.row();
+  int c1 = topLeft.column(), c2 = bottomRight.column();
+
+  if (r1 < 0 || r2 >= int(sourceRowDatas_.size())) {
+    rebuild();
+    return;
+  }
+
+  // skip if no key or aggregate column changed
+  bool used = false;
+
+  for (const auto &c : keyColumns_)
+    if (c >= c1 && c <= c2) used = true;
+
+  for (const auto &aggregate : aggregates_)
+    if (aggregate.column >= c1 && aggregate.column <= c2) used = true;
+
+  if (! used)
+    return;
+
+  //---
+
+  // replace contribution of changed rows
+  Rows changedRows;
+
+  for (int r = r1; r <= r2; ++r) {
+    auto &rowData = sourceRowDatas_[size_t(r)];
+
+    removeRowData(rowData, changedRows);
+
+    calcRowData(r, rowData);
+
+    addRowData(rowData, changedRows, /*notify*/true);
+  }
+
+  removeEmptyGroups(changedRows);
+
+  for (const auto &r : changedRows)
+    updateGroupRow(r);
+
+  emitRowsChanged(changedRows);
+}
+
+void
+CQPivotModel::
+sourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+  if (parent.isValid())
+    return;
+
+  if (first < 0 || first > int(sourceRowDatas_.size())) {
+    rebuild();
+    return;
+  }
+
+  // insert contributions of new rows (later rows shift down)
+  sourceRowDatas_.insert(sourceRowDatas_.begin() + first, size_t(last - first + 1),
+                         SourceRowData());
+
+  Rows changedRows;
+
+  for (int r = first; r <= last; ++r) {
+    auto &rowData = sourceRowDatas_[size_t(r)];
+
+    calcRowData(r, rowData);
+
+    addRowData(rowData, changedRows, /*notify*/true);
+  }
+
+  for (const auto &r : changedRows)
+    updateGroupRow(r);
+
+  emitRowsChanged(changedRows);
+}
+
+void
+CQPivotModel::
+sourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+  if (parent.isValid())
+    return;
+
+  if (first < 0 || last >= int(sourceRowDatas_.size())) {
+    rebuild();
+    return;
+  }
+
+  // remove contributions of removed rows
+  Rows changedRows;
+
+  for (int r = first; r <= last; ++r)
+    removeRowData(sourceRowDatas_[size_t(r)], changedRows);
+
+  sourceRowDatas_.erase(sourceRowDatas_.begin() + first, sourceRowDatas_.begin() + last + 1);
+
+  removeEmptyGroups(changedRows);
+
+  for (const auto &r : changedRows)
+    updateGroupRow(r);
+
+  emitRowsChanged(changedRows);
+}
+
+void
+CQPivotModel::
+sourceReset()
+{
+  rebuild();
+}
+
+//---
+
+void
+CQPivotModel::
+calcRowData(int row, SourceRowData &rowData) const
+{
+  QModelIndex parent;
+
+  QStringList keyStrs;
+
+  rowData.keyValues.clear();
+
+  for (const auto &c : keyColumns_) {
+    bool ok;
+
+    auto var = CQModelUtil::modelValue(sourceModel_, row, c, parent, ok);
+
+    rowData.keyValues.push_back(var);
+
+    // same value equality (type and value) as group by model
+    keyStrs.push_back(CQModelUtil::variantKey(var));
+  }
+
+  rowData.key = keyStrs.join(QChar(0x1f));
+
+  //---
+
+  auto na = aggregates_.size();
+
+  rowData.values.resize(na);
+
+  for (size_t i = 0; i < na; ++i) {
+    const auto &aggregate = aggregates_[i];
+
+    auto &rowValue = rowData.values[i];
+
+    rowValue = SourceRowValue();
+
+    if (aggregate.column < 0)
+      continue;
+
+    auto ind = sourceModel_->index(row, aggregate.column, parent);
+
+    bool ok;
+
+    auto value = CQModelUtil::modelReal(sourceModel_, ind, ok);
+
+    if (ok) {
+      rowValue.valid = true;
+      rowValue.value = value;
+    }
+  }
+}
+
+void
+CQPivotModel::
+addRowData(const SourceRowData &rowData, Rows &changedRows, bool notify)
+{
+  auto na = aggregates_.size();
+
+  int row;
+
+  auto pg = groupRows_.find(rowData.key);
+
+  if (pg == groupRows_.end()) {
+    // add new group (and model row)
+    row = int(groupDatas_.size());
+
+    GroupData groupData;
+
+    groupData.key = rowData.key;
+
+    groupData.aggregateValues.resize(na);
+
+    groupDatas_.push_back(std::move(groupData));
+
+    groupRows_[rowData.key] = row;
+
+    if (notify)
+      addRow(1);
+    else {
+      WriteLock lock(mutex_);
+
+      data_.push_back(Cells(size_t(columnCount())));
+    }
+
+    int nk = int(keyColumns_.size());
+
+    for (int c = 0; c < nk; ++c)
+      setModelData(row, c, rowData.keyValues[c]);
+  }
+  else
+    row = (*pg).second;
+
+  //---
+
+  auto &groupData = groupDatas_[size_t(row)];
+
+  ++groupData.numRows;
+
+  for (size_t i = 0; i < na; ++i)
+    groupData.aggregateValues[i].add(rowData.values[i], isKeepValues(aggregates_[i]));
+
+  changedRows.insert(row);
+}
+
+void
+CQPivotModel::
+removeRowData(const SourceRowData &rowData, Rows &changedRows)
+{
+  auto pg = groupRows_.find(rowData.key);
+  if (pg == groupRows_.end()) return;
+
+  int row = (*pg).second;
+
+  auto &groupData = groupDatas_[size_t(row)];
+
+  --groupData.numRows;
+
+  auto na = aggregates_.size();
+
+  for (size_t i = 0; i < na; ++i)
+    groupData.aggregateValues[i].remove(rowData.values[i], isKeepValues(aggregates_[i]));
+
+  changedRows.insert(row);
+}
+
+void
+CQPivotModel::
+removeEmptyGroups(Rows &changedRows)
+{
+  // remove rows of groups with no source rows (last first so rows stay valid)
+  Rows removedRows;
+
+  for (auto pr = changedRows.rbegin(); pr != changedRows.rend(); ++pr) {
+    int row = *pr;
+
+    if (groupDatas_[size_t(row)].numRows > 0)
+      continue;
+
+    cancelRefineColumnTypes();
+
+    beginRemoveRows(QModelIndex(), row, row);
+
+    groupRows_.erase(groupDatas_[size_t(row)].key);
+
+    groupDatas_.erase(groupDatas_.begin() + row);
+
+    {
+    WriteLock lock(mutex_);
+
+    data_.erase(size_t(row));
+    }
+
+    if (! vheader_.empty())
+      vheader_.erase(vheader_.begin() + row);
+
+    endRemoveRows();
+
+    removedRows.insert(row);
+  }
+
+  if (removedRows.empty())
+    return;
+
+  clearCachedColumn();
+
+  //---
+
+  // update group rows and move remaining changed rows up past removed rows
+  int ng = int(groupDatas_.size());
+
+  for (int r = 0; r < ng; ++r)
+    groupRows_[groupDatas_[size_t(r)].key] = r;
+
+  Rows changedRows1;
+
+  for (const auto &row : changedRows) {
+    if (removedRows.find(row) != removedRows.end())
+      continue;
+
+    auto numRemoved = std::distance(removedRows.begin(), removedRows.lower_bound(row));
+
+    changedRows1.insert(row - int(numRemoved));
+  }
+
+  changedRows = std::move(changedRows1);
+}
+
+void
+CQPivotModel::
+updateGroupRow(int row)
+{
+  const auto &groupData = groupDatas_[size_t(row)];
+
+  int nk = int(keyColumns_.size());
+  int na = int(aggregates_.size());
+
+  for (int c = 0; c < na; ++c) {
+    const auto &aggregate = aggregates_[size_t(c)];
+
+    auto value = groupData.aggregateValues[size_t(c)].value(aggregate.type);
+
+    setModelData(row, nk + c, value);
+  }
+}
+
+void
+CQPivotModel::
+emitRowsChanged(const Rows &rows)
+{
+  if (rows.empty())
+    return;
+
+  // include key columns for new groups
+  int nc = columnCount();
+
+  Q_EMIT dataChanged(index(*rows.begin(), 0), index(*rows.rbegin(), nc - 1));
+}
+
+bool
+CQPivotModel::
+isKeepValues(const Aggregate &aggregate) const
+{
+  return (aggregate.type == AggregateType::MIN ||
+          aggregate.type == AggregateType::MAX ||
+          aggregate.type == AggregateType::MEDIAN);
+}
+
+//------
+
+void
+CQPivotModel::AggregateValues::
+add(const SourceRowValue &value, bool keepValues)
+{
+  ++count;
+
+  if (! value.valid)
+    return;
+
+  ++nvalue;
+
+  sum += value.value;
+
+  if (keepValues) {
+    if (lower.empty() || value.value <= *lower.rbegin())
+      lower.insert(value.value);
+    else
+      upper.insert(value.value);
+
+    balance();
+  }
+}
+
+void
+CQPivotModel::AggregateValues::
+remove(const SourceRowValue &value, bool keepValues)
+{
+  --count;
+
+  if (! value.valid)
+    return;
+
+  --nvalue;
+
+  sum -= value.value;
+
+  if (keepValues) {
+    // values less than or equal to lower max are in lower set
+    if (! lower.empty() && value.value <= *lower.rbegin()) {
+      auto pv = lower.find(value.value);
+
+      if (pv != lower.end())
+        lower.erase(pv);
+    }
+    else {
+      auto pv = upper.find(value.value);
+
+      if (pv != upper.end())
+        upper.erase(pv);
+    }
+
+    balance();
+  }
+
+  // reset sum to avoid accumulated rounding errors
+  if (nvalue == 0)
+    sum = 0.0;
+}
+
+void
+CQPivotModel::AggregateValues::
+balance()
+{
+  // keep lower size equal to upper size or one more
+  if      (lower.size() > upper.size() + 1) {
+    auto pl = std::prev(lower.end());
+
+    upper.insert(*pl);
+    lower.erase(pl);
+  }
+  else if (upper.size() > lower.size()) {
+    auto pu = upper.begin();
+
+    lower.insert(*pu);
+    upper.erase(pu);
+  }
+}
+
+QVariant
+CQPivotModel::AggregateValues::
+value(AggregateType type) const
+{
+  if (type == AggregateType::COUNT)
+    return QVariant(count);
+
+  if (nvalue == 0)
+    return QVariant();
+
+  switch (type) {
+    case AggregateType::SUM : return QVariant(sum);
+    case AggregateType::MIN : return QVariant(*lower.begin());
+    case AggregateType::MAX :
+      return QVariant(upper.empty() ? *lower.rbegin() : *upper.rbegin());
+    case AggregateType::MEAN: return QVariant(sum/nvalue);
+    case AggregateType::MEDIAN: {
+      if (lower.size() > upper.size())
+        return QVariant(*lower.rbegin());
+
+      return QVariant((*lower.rbegin() + *upper.begin())/2.0);
+    }
+    default:
+      return QVariant();
+  }
+}
@@ -9,39 +9,467 @@ CQSortModel(QAbstractItemModel *model) :
   setSourceModel(model);
 }
 
+void
+CQSortModel::
+setSourceModel(QAbstractItemModel *model)
+{
+  // connect before base class so row bitmaps are updated before proxy re-filters rows
+  if (filterModel_) {
+    disconnect(filterModel_, SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)),
+               this, SLOT(updateFilterRows(const QModelIndex &, const QModelIndex &)));
+    disconnect(filterModel_, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+               this, SLOT(insertFilterRows(const QModelIndex &, int, int)));
+    disconnect(filterModel_, SIGNAL(rowsRemoved(const QModelIndex &, int, int)),
+               this, SLOT(removeFilterRows(const QModelIndex &, int, int)));
+    disconnect(filterModel_, SIGNAL(rowsMoved(const QModelIndex &, int, int,
+                                              const QModelIndex &, int)),
+               this, SLOT(resetFilterRows()));
+    disconnect(filterModel_, SIGNAL(layoutChanged()), this, SLOT(resetFilterRows()));
+    disconnect(filterModel_, SIGNAL(modelReset()), this, SLOT(resetFilterRows()));
+  }
+
+  filterModel_ = model;
+
+  if (filterModel_) {
+    connect(filterModel_, SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)),
+            this, SLOT(updateFilterRows(const QModelIndex &, const QModelIndex &)));
+    connect(filterModel_, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+            this, SLOT(insertFilterRows(const QModelIndex &, int, int)));
+    connect(filterModel_, SIGNAL(rowsRemoved(const QModelIndex &, int, int)),
+            this, SLOT(removeFilterRows(const QModelIndex &, int, int)));
+    connect(filterModel_, SIGNAL(rowsMoved(const QModelIndex &, int, int,
+                                           const QModelIndex &, int)),
+            this, SLOT(resetFilterRows()));
+    connect(filterModel_, SIGNAL(layoutChanged()), this, SLOT(resetFilterRows()));
+    connect(filterModel_, SIGNAL(modelReset()), this, SLOT(resetFilterRows()));
+  }
+
+  rowsValid_ = false;
+
+  QSortFilterProxyModel::setSourceModel(model);
+}
+
 void
 CQSortModel::
 setFilter(const QString &filter)
 {
   filter_ = filter;
 
+  //---
+
+  // old clause rows can only be reused if built with same filter settings
+  bool stateValid = isFilterStateValid();
+
+  FilterClauses clauses;
+
+  parseClauses(filter, clauses);
+
+  //---
+
+  if (rowsValid_ && stateValid) {
+    // reuse rows of matching old clause (same column and same or refined pattern)
+    for (auto &clause : clauses) {
+      const FilterClause *oldClause = nullptr;
+
+      for (const auto &clause1 : clauses_) {
+        if (clause1.column == clause.column &&
+            isRefinedPattern(clause1.pattern, clause.pattern)) {
+          oldClause = &clause1;
+          break;
+        }
+      }
+
+      calcClauseRows(clause, oldClause);
+    }
+
+    clauses_ = std::move(clauses);
+
+    // removed clauses just drop out of the combined bitmap
+    updateAcceptedRows();
+  }
+  else {
+    clauses_ = std::move(clauses);
+
+    initFilterRows();
+  }
+
+  invalidateFilter();
+}
+
+void
+CQSortModel::
+parseClauses(const QString &filter, FilterClauses &clauses)
+{
+  // parse comma separated clauses
+  auto strs = splitClauses(filter);
+
+  for (const auto &str : strs) {
+    FilterClause clause;
+
+    if (parseClause(str, clause))
+      clauses.push_back(clause);
+  }
+
+  // save filter settings used by clauses
+  clauseColumn_ = filterKeyColumn();
+  clauseRole_   = filterRole();
+  clauseCase_   = filterCaseSensitivity();
+}
+
+QStringList
+CQSortModel::
+splitClauses(const QString &filter) const
+{
+  QStringList strs;
+
+  // no clause prefix then single pattern (commas are part of pattern)
+  if (! filter.contains(':')) {
+    if (filter.length())
+      strs.push_back(filter);
+
+    return strs;
+  }
+
+  // split on unescaped commas ('\,' is a literal comma)
+  QString str;
+
+  int len = filter.length();
+
+  for (int i = 0; i < len; ++i) {
+    auto c = filter[i];
+
+    if      (c == '\\' && i + 1 < len && filter[i + 1] == ',') {
+      str += ',';
+
+      ++i;
+    }
+    else if (c == ',') {
+      if (str.length())
+        strs.push_back(str);
+
+      str.clear();
+    }
+    else
+      str += c;
+  }
+
+  if (str.length())
+    strs.push_back(str);
+
+  return strs;
+}
+
+bool
+CQSortModel::
+parseClause(const QString &str, FilterClause &clause) const
+{
   auto *model = sourceModel();
 
-  auto strs = filter.split(':', Qt::KeepEmptyParts);
+  clause.column = filterKeyColumn();
+
+  auto strs = str.split(':', Qt::KeepEmptyParts);
 
   if (strs.size() == 2) {
-    auto name   = strs[0];
-    auto filter = strs[1];
+    auto name = strs[0];
 
     int column = -1;
 
-    for (int i = 0; i < model->columnCount(); ++i) {
-      auto name1 = model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString();
+    if (model) {
+      for (int i = 0; i < model->columnCount(); ++i) {
+        auto name1 = model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString();
 
-      if (name == name1) {
-        column = i;
-        break;
+        if (name == name1) {
+          column = i;
+          break;
+        }
       }
     }
 
-    if (column > 0)
-      setFilterKeyColumn(column);
+    if (column < 0) {
+      bool ok;
+
+      column = name.toInt(&ok);
+
+      if (! ok)
+        column = -1;
+    }
+
+    if (column >= 0)
+      clause.column = column;
+
+    clause.pattern = strs[1];
+  }
+  else {
+    clause.pattern = str;
+  }
+
+  clause.regexp = QRegExp(clause.pattern, filterCaseSensitivity(), QRegExp::Wildcard);
+
+  return true;
+}
+
+bool
+CQSortModel::
+isRefinedPattern(const QString &oldPattern, const QString &newPattern) const
+{
+  // new pattern extends old pattern so (for contains match) it can only accept a
+  // subset of the old rows. Bracket sets and escapes could change meaning when
+  // extended so need a full re-test.
+  if (! newPattern.startsWith(oldPattern))
+    return false;
+
+  if (oldPattern.contains('[') || oldPattern.contains('\\'))
+    return false;
+
+  return true;
+}
+
+void
+CQSortModel::
+calcClauseRows(FilterClause &clause, const FilterClause *oldClause) const
+{
+  auto *model = sourceModel();
+
+  int nr = (model ? model->rowCount() : 0);
 
-    filter = strs[1];
+  QModelIndex parent;
 
-    setFilterWildcard(filter);
+  if (oldClause && oldClause->rowBits.size() == size_t(nr)) {
+    clause.rowBits = oldClause->rowBits;
+
+    if (oldClause->pattern == clause.pattern)
+      return;
+
+    // only re-test rows accepted by old pattern
+    for (int r = 0; r < nr; ++r) {
+      if (clause.rowBits[size_t(r)] && ! clauseAcceptsRow(clause, r, parent))
+        clause.rowBits[size_t(r)] = false;
+    }
   }
   else {
-    setFilterWildcard(filter_);
+    clause.rowBits.resize(size_t(nr));
+
+    for (int r = 0; r < nr; ++r)
+      clause.rowBits[size_t(r)] = clauseAcceptsRow(clause, r, parent);
+  }
+}
+
+bool
+CQSortModel::
+clauseAcceptsRow(const FilterClause &clause, int row, const QModelIndex &parent) const
+{
+  auto *model = sourceModel();
+  if (! model) return true;
+
+  int nc = model->columnCount(parent);
+
+  // no column then match any column
+  if (clause.column < 0) {
+    for (int c = 0; c < nc; ++c) {
+      auto ind = model->index(row, c, parent);
+
+      auto str = model->data(ind, filterRole()).toString();
+
+      if (clause.regexp.indexIn(str) >= 0)
+        return true;
+    }
+
+    return false;
   }
+
+  // invalid column is ignored
+  if (clause.column >= nc)
+    return true;
+
+  auto ind = model->index(row, clause.column, parent);
+
+  auto str = model->data(ind, filterRole()).toString();
+
+  return (clause.regexp.indexIn(str) >= 0);
+}
+
+bool
+CQSortModel::
+isFilterStateValid() const
+{
+  return (clauseColumn_ == filterKeyColumn() &&
+          clauseRole_   == filterRole() &&
+          clauseCase_   == filterCaseSensitivity());
+}
+
+void
+CQSortModel::
+updateFilterState()
+{
+  // clause columns, regexps and row bitmaps depend on filter settings so rebuild all
+  FilterClauses clauses;
+
+  parseClauses(filter_, clauses);
+
+  clauses_ = std::move(clauses);
+
+  initFilterRows();
+}
+
+void
+CQSortModel::
+initFilterRows()
+{
+  for (auto &clause : clauses_)
+    calcClauseRows(clause, nullptr);
+
+  updateAcceptedRows();
+}
+
+void
+CQSortModel::
+updateAcceptedRows()
+{
+  auto *model = sourceModel();
+
+  int nr = (model ? model->rowCount() : 0);
+
+  acceptedRows_.assign(size_t(nr), true);
+
+  for (const auto &clause : clauses_) {
+    for (int r = 0; r < nr; ++r) {
+      if (! clause.rowBits[size_t(r)])
+        acceptedRows_[size_t(r)] = false;
+    }
+  }
+
+  rowsValid_ = true;
+}
+
+void
+CQSortModel::
+resetFilterRows()
+{
+  rowsValid_ = false;
+}
+
+void
+CQSortModel::
+insertFilterRows(const QModelIndex &parent, int first, int last)
+{
+  if (! rowsValid_ || parent.isValid())
+    return;
+
+  if (first < 0 || size_t(first) > acceptedRows_.size() || last < first) {
+    rowsValid_ = false;
+    return;
+  }
+
+  // insert and test only new rows (later rows move down)
+  auto n = size_t(last - first + 1);
+
+  for (auto &clause : clauses_)
+    clause.rowBits.insert(clause.rowBits.begin() + first, n, false);
+
+  acceptedRows_.insert(acceptedRows_.begin() + first, n, true);
+
+  for (int r = first; r <= last; ++r) {
+    bool accepted = true;
+
+    for (auto &clause : clauses_) {
+      clause.rowBits[size_t(r)] = clauseAcceptsRow(clause, r, parent);
+
+      if (! clause.rowBits[size_t(r)])
+        accepted = false;
+    }
+
+    acceptedRows_[size_t(r)] = accepted;
+  }
+}
+
+void
+CQSortModel::
+removeFilterRows(const QModelIndex &parent, int first, int last)
+{
+  if (! rowsValid_ || parent.isValid())
+    return;
+
+  if (first < 0 || size_t(last) >= acceptedRows_.size() || last < first) {
+    rowsValid_ = false;
+    return;
+  }
+
+  // remove rows (later rows move up)
+  for (auto &clause : clauses_)
+    clause.rowBits.erase(clause.rowBits.begin() + first, clause.rowBits.begin() + last + 1);
+
+  acceptedRows_.erase(acceptedRows_.begin() + first, acceptedRows_.begin() + last + 1);
+}
+
+void
+CQSortModel::
+updateFilterRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+  if (! rowsValid_ || topLeft.parent().isValid())
+    return;
+
+  // re-test changed rows for clauses on changed columns
+  int r1 = topLeft.row(), r2 = bottomRight.row();
+  int c1 = topLeft.column(), c2 = bottomRight.column();
+
+  if (r1 < 0 || size_t(r2) >= acceptedRows_.size()) {
+    rowsValid_ = false;
+    return;
+  }
+
+  QModelIndex parent;
+
+  for (int r = r1; r <= r2; ++r) {
+    bool accepted = true;
+
+    for (auto &clause : clauses_) {
+      if (clause.column < 0 || (clause.column >= c1 && clause.column <= c2))
+        clause.rowBits[size_t(r)] = clauseAcceptsRow(clause, r, parent);
+
+      if (! clause.rowBits[size_t(r)])
+        accepted = false;
+    }
+
+    acceptedRows_[size_t(r)] = accepted;
+  }
+}
+
+bool
+CQSortModel::
+filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+  if (! QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent))
+    return false;
+
+  if (clauses_.empty())
+    return true;
+
+  // filter key column, role or case sensitivity changed (base class setters invalidate
+  // filter so detected here)
+  if (! isFilterStateValid()) {
+    auto *th = const_cast<CQSortModel *>(this);
+
+    th->updateFilterState();
+  }
+
+  // child rows are not in bitmaps so test directly
+  if (sourceParent.isValid()) {
+    for (const auto &clause : clauses_) {
+      if (! clauseAcceptsRow(clause, sourceRow, sourceParent))
+        return false;
+    }
+
+    return true;
+  }
+
+  if (! rowsValid_ || size_t(sourceRow) >= acceptedRows_.size()) {
+    auto *th = const_cast<CQSortModel *>(this);
+
+    th->initFilterRows();
+  }
+
+  if (sourceRow < 0 || size_t(sourceRow) >= acceptedRows_.size())
+    return false;
+
+  return acceptedRows_[size_t(sourceRow)];
 }
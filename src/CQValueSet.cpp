@@ -1,6 +1,6 @@
 #include <CQValueSet.h>
 #include <CQModelUtil.h>
-#include <CQTrie.h>
+#include <algorithm>
 
 CQValueSet::
 CQValueSet()
@@ -34,6 +34,8 @@ addValue(const QVariant &value)
   values_.push_back(value);
 
   initialized_ = false;
+
+  resetMapValues();
 }
 
 void
@@ -45,6 +47,8 @@ clear()
   values_.clear();
 
   initialized_ = false;
+
+  resetMapValues();
 }
 
 bool
@@ -127,10 +131,55 @@ double
 CQValueSet::
 imap(int i) const
 {
+  assert(hasInd(i));
+
+  initMapValues();
+
+  return mapValues_[size_t(i)];
+}
+
+int
+CQValueSet::
+imapAll(double *values, int n) const
+{
+  initMapValues();
+
+  n = std::min(std::max(n, 0), int(mapValues_.size()));
+
+  std::copy(mapValues_.begin(), mapValues_.begin() + n, values);
+
+  return n;
+}
+
+void
+CQValueSet::
+initMapValues() const
+{
+  // ensure values initialized before taking lock (init locks same mutex)
+  init();
+
+  if (mapValuesValid_)
+    return;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (mapValuesValid_)
+    return;
+
+  auto *th = const_cast<CQValueSet *>(this);
+
+  // map all values once (string values need set lookup)
   double min = mapMin();
   double max = std::max(min, mapMax());
 
-  return imap(i, min, max);
+  int n = numValues();
+
+  th->mapValues_.resize(size_t(n));
+
+  for (int i = 0; i < n; ++i)
+    th->mapValues_[size_t(i)] = (hasInd(i) ? imap(i, min, max) : min);
+
+  th->mapValuesValid_ = true;
 }
 
 double
@@ -419,6 +468,8 @@ init()
 {
   initialized_ = true;
 
+  resetMapValues();
+
   // if no type then look at added values
   if (type_ == Type::NONE)
     type_ = calcType();
@@ -528,39 +579,39 @@ clearVals()
 
 //------
 
-int
+void
 CQRValues::
 addValue(const OptReal &r)
 {
-  // add to all values
+  // add to all values (unique values are indexed on demand)
   values_.push_back(r);
 
   calculated_ = false;
 
-  // TODO: don't calc key unless needed
+  calcValid_  .store(false);
+  uniqueValid_.store(false);
 
-  // TODO: assert
   if (! r) {
     ++numNull_;
 
-    return -1;
+    return;
   }
 
-  // add to unique values if new
-  auto p = valset_.find(*r);
-
-  if (p == valset_.end()) {
-    int id = int(valset_.size());
+  // update range
+  if (! minValue_ || *r < *minValue_) minValue_ = *r;
+  if (! maxValue_ || *r > *maxValue_) maxValue_ = *r;
+}
 
-    p = valset_.insert(p, ValueSet::value_type(*r, KeyCount(id, 1))); // id for value
+void
+CQRValues::
+calcUnique()
+{
+  valueIndex_.clear();
 
-    setvals_[id] = *r; // value for id
+  for (const auto &r : values_) {
+    if (r)
+      (void) valueIndex_.add(*r);
   }
-  else {
-    ++(*p).second.second; // increment count
-  }
-
-  return (*p).second.first; // return key
 }
 
 void
@@ -633,39 +684,39 @@ isOutlier(double v) const
 
 //------
 
-int
+void
 CQIValues::
 addValue(const OptInt &i)
 {
-  // add to all values
+  // add to all values (unique values are indexed on demand)
   values_.push_back(i);
 
   calculated_ = false;
 
-  // TODO: don't calc key unless needed
+  calcValid_  .store(false);
+  uniqueValid_.store(false);
 
-  // TODO: assert
   if (! i) {
     ++numNull_;
 
-    return -1;
+    return;
   }
 
-  // add to unique values if new
-  auto p = valset_.find(*i);
-
-  if (p == valset_.end()) {
-    int id = int(valset_.size());
+  // update range
+  if (! minValue_ || *i < *minValue_) minValue_ = *i;
+  if (! maxValue_ || *i > *maxValue_) maxValue_ = *i;
+}
 
-    p = valset_.insert(p, ValueSet::value_type(*i, KeyCount(id, 1))); // id for value
+void
+CQIValues::
+calcUnique()
+{
+  valueIndex_.clear();
 
-    setvals_[id] = *i; // value for id
-  }
-  else {
-    ++(*p).second.second; // increment count
+  for (const auto &i : values_) {
+    if (i)
+      (void) valueIndex_.add(*i);
   }
-
-  return (*p).second.first; // return key
 }
 
 void
@@ -739,77 +790,84 @@ isOutlier(long v) const
 CQSValues::
 CQSValues()
 {
-  trie_      = new CQTrie;
-  spatterns_ = new CQTriePatterns;
 }
 
 CQSValues::
 ~CQSValues()
 {
-  delete trie_;
-  delete spatterns_;
 }
 
 void
 CQSValues::
 clear()
 {
-  values_ .clear();
-  valset_ .clear();
-  setvals_.clear();
+  values_    .clear();
+  valueIndex_.clear();
 
   numNull_ = 0;
 
-  trie_->clear();
+  minValue_.reset();
+  maxValue_.reset();
 
-  spatterns_->clear();
+  uniqueValid_.store(false);
+
+  bucketIds_.clear();
+  spatterns_.clear();
 
   spatternsSet_ = false;
 }
 
-int
+void
 CQSValues::
 addValue(const OptString &s)
 {
-  // add to all values
+  // add to all values (unique values are indexed on demand)
   values_.push_back(s);
 
-  // TODO: don't calc key unless needed
+  uniqueValid_.store(false);
+
+  spatternsSet_ = false;
 
-  // TODO: assert
   if (! s) {
     ++numNull_;
 
-    return -1;
+    return;
   }
 
-  // add to trie
-  trie_->addWord(*s);
-
-  // add to unique values if new
-  auto p = valset_.find(*s);
-
-  if (p == valset_.end()) {
-    int id = int(valset_.size());
+  // update range
+  if (! minValue_ || *s < *minValue_) minValue_ = *s;
+  if (! maxValue_ || *s > *maxValue_) maxValue_ = *s;
+}
 
-    p = valset_.insert(p, ValueSet::value_type(*s, KeyCount(id, 1))); // id for value
+void
+CQSValues::
+calcUnique()
+{
+  valueIndex_.clear();
 
-    setvals_[id] = *s; // value for id
-  }
-  else {
-    ++(*p).second.second; // increment count
+  for (const auto &s : values_) {
+    if (s)
+      (void) valueIndex_.add(*s);
   }
-
-  return (*p).second.first; // return key
 }
 
 int
 CQSValues::
 sbucket(const QString &s) const
+{
+  return ibucket(id(s));
+}
+
+int
+CQSValues::
+ibucket(int id) const
 {
   initPatterns(initBuckets_);
 
-  return trie_->patternIndex(s, *spatterns_);
+  if (id < 0 || id >= int(bucketIds_.size()))
+    return -1;
+
+  return bucketIds_[size_t(id)];
 }
 
 QString
@@ -818,7 +876,19 @@ buckets(int i) const
 {
   initPatterns(initBuckets_);
 
-  return trie_->indexPattern(i, *spatterns_);
+  if (i < 0 || i >= int(spatterns_.size()))
+    return "";
+
+  return spatterns_[size_t(i)];
+}
+
+int
+CQSValues::
+numBuckets() const
+{
+  initPatterns(initBuckets_);
+
+  return int(spatterns_.size());
 }
 
 void
@@ -828,41 +898,80 @@ initPatterns(int numIdeal) const
   if (spatternsSet_)
     return;
 
+  initUnique();
+
   std::unique_lock<std::mutex> lock(mutex_);
 
   if (! spatternsSet_) {
     auto *th = const_cast<CQSValues *>(this);
 
-    using DepthCountMap = std::map<int, CQTriePatterns>;
+    // buckets are the unique string prefixes of the depth (1-3) whose number of
+    // prefixes is nearest the ideal number of buckets. Prefixes are computed once
+    // per unique string (not per value) and each unique string id stores its bucket
+    using Prefixes = std::vector<QString>;
 
-    DepthCountMap depthCountMap;
+    const auto &uniqueValues = valueIndex_.values();
 
-    for (int depth = 1; depth <= 3; ++depth) {
-      CQTriePatterns patterns;
+    auto nu = uniqueValues.size();
 
-      trie_->patterns(depth, patterns);
+    auto uniquePrefixes = [&](int depth, Prefixes &prefixes) {
+      prefixes.clear();
+      prefixes.reserve(nu);
 
-      depthCountMap[depth] = patterns;
+      for (const auto &str : uniqueValues)
+        prefixes.push_back(str.left(depth));
 
-      //patterns.print(std::cerr);
-    }
+      std::sort(prefixes.begin(), prefixes.end());
+
+      prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+    };
+
+    int      minD     = -1;
+    int      minDepth = -1;
+    Prefixes minPrefixes;
+
+    for (int depth = 1; depth <= 3; ++depth) {
+      Prefixes prefixes;
 
-    int minD     = -1;
-    int minDepth = -1;
+      uniquePrefixes(depth, prefixes);
 
-    for (const auto &depthCount : depthCountMap) {
-      int d = std::abs(depthCount.second.numPatterns() - numIdeal);
+      int d = std::abs(int(prefixes.size()) - numIdeal);
 
       if (minDepth < 0 || d < minD) {
-        minD     = d;
-        minDepth = depthCount.first;
+        minD        = d;
+        minDepth    = depth;
+        minPrefixes = std::move(prefixes);
       }
     }
 
-    *th->spatterns_ = depthCountMap[minDepth];
+    //---
 
-    th->spatternsSet_ = true;
+    // bucket id per unique string id
+    std::vector<bool> truncated(minPrefixes.size(), false);
+
+    th->bucketIds_.resize(nu);
+
+    for (size_t id = 0; id < nu; ++id) {
+      const auto &str = uniqueValues[id];
+
+      auto prefix = str.left(minDepth);
+
+      auto pp = std::lower_bound(minPrefixes.begin(), minPrefixes.end(), prefix);
+
+      auto ib = size_t(std::distance(minPrefixes.begin(), pp));
 
-    //spatterns_->print(std::cerr);
+      th->bucketIds_[id] = int(ib);
+
+      if (str.length() > minDepth)
+        truncated[ib] = true;
+    }
+
+    // patterns (prefix with '*' if matches longer strings)
+    th->spatterns_.resize(minPrefixes.size());
+
+    for (size_t ib = 0; ib < minPrefixes.size(); ++ib)
+      th->spatterns_[ib] = (truncated[ib] ? minPrefixes[ib] + "*" : minPrefixes[ib]);
+
+    th->spatternsSet_ = true;
   }
 }
@@ -0,0 +1,452 @@
+#include <CQDataModel.h>
+#include <CQModelDetails.h>
+#include <CQModelVisitor.h>
+#include <CQPivotModel.h>
+#include <CQSortModel.h>
+
+#include <QApplication>
+
+#include <iostream>
+#include <vector>
+
+// non-interactive checks of model behavior (exit status is number of failed tests)
+
+namespace {
+
+int s_numChecks = 0;
+int s_numFailed = 0;
+
+#define CHECK(expr) check((expr), #expr, __FILE__, __LINE__)
+
+bool check(bool b, const char *expr, const char *file, int line) {
+  ++s_numChecks;
+
+  if (! b) {
+    std::cerr << file << ":" << line << ": check failed: " << expr << "\n";
+
+    ++s_numFailed;
+  }
+
+  return b;
+}
+
+//---
+
+//! data model with row removal (for source model row removed signals) and column map
+class TestDataModel : public CQDataModel {
+ public:
+  TestDataModel(int nc, int nr) :
+   CQDataModel(nc, nr) {
+  }
+
+  using CQDataModel::setColumnMap;
+
+  void removeRow(int row) {
+    beginRemoveRows(QModelIndex(), row, row);
+
+    data_.erase(size_t(row));
+
+    endRemoveRows();
+
+    clearCachedColumn();
+  }
+};
+
+//---
+
+void setCell(CQDataModel &model, int row, int column, const QVariant &value) {
+  model.setData(model.index(row, column), value, Qt::EditRole);
+}
+
+void addRow(CQDataModel &model, const QVariant &value) {
+  int row = model.rowCount();
+
+  model.addRow();
+
+  setCell(model, row, 0, value);
+}
+
+// key column lookup and duplicates (key index extended on row append)
+void testKeyColumn() {
+  CQDataModel model(2, 0);
+
+  model.setColumnKey(0, true);
+
+  addRow(model, "a");
+  addRow(model, "b");
+
+  CHECK(model.rowForKey(0, "a") == 0);
+  CHECK(model.rowForKey(0, "b") == 1);
+  CHECK(model.rowForKey(0, "c") == -1);
+  CHECK(! model.hasKeyDuplicates(0));
+
+  // appended rows are found after index built
+  addRow(model, "c");
+  addRow(model, "a");
+
+  CHECK(model.rowForKey(0, "c") == 2);
+  CHECK(model.hasKeyDuplicates(0));
+  CHECK(model.keyDuplicates(0) == std::vector<int>({3}));
+
+  // changed value moves row in index
+  setCell(model, 3, 0, "d");
+
+  CHECK(model.rowForKey(0, "d") == 3);
+  CHECK(! model.hasKeyDuplicates(0));
+
+  // values match on type and value
+  addRow(model, QVariant(1));
+
+  CHECK(model.rowForKey(0, QVariant(1  )) == 4);
+  CHECK(model.rowForKey(0, QVariant(1.0)) == 4);
+  CHECK(model.rowForKey(0, QVariant(QString("1"))) == -1);
+  CHECK(! model.hasKeyDuplicates(0));
+
+  // base class (non-indexed) duplicates use same rule
+  model.setColumnKey(0, false);
+
+  addRow(model, QVariant(QString("1")));
+
+  CHECK(model.keyDuplicates(0).empty());
+
+  addRow(model, QVariant(1.0));
+
+  CHECK(model.keyDuplicates(0) == std::vector<int>({6}));
+}
+
+
+// indexed column value lookup matches non-indexed (QVariant ==) lookup
+void testColumnIndex() {
+  CQDataModel model(1, 0);
+
+  QVariantList values = {
+    QVariant(QString("1")), QVariant(1), QVariant(1.0), QVariant(true),
+    QVariant(QString("abc")), QVariant(2.5), QVariant(QString("2.5")) };
+
+  for (const auto &value : values)
+    addRow(model, value);
+
+  for (const auto &value : values) {
+    model.setColumnIndexed(0, false);
+
+    auto rows  = model.findColumnValues(0, value);
+    auto row   = model.findColumnValue (0, value);
+
+    model.setColumnIndexed(0, true);
+
+    auto irows = model.findColumnValues(0, value);
+    auto irow  = model.findColumnValue (0, value);
+
+    CHECK(irows == rows);
+    CHECK(irow  == row);
+  }
+
+  // string cell found by numeric value
+  CHECK(model.findColumnValue(0, QVariant(1)) == 0);
+}
+
+// sort model filter rows updated for data, row and filter setting changes
+void testSortFilter() {
+  CQDataModel model(2, 0);
+
+  addRow(model, "apple"  ); setCell(model, 0, 1, "x" );
+  addRow(model, "apricot"); setCell(model, 1, 1, "y" );
+  addRow(model, "banana" ); setCell(model, 2, 1, "xy");
+
+  CQSortModel sortModel(&model);
+
+  sortModel.setFilter("ap");
+
+  CHECK(sortModel.rowCount() == 2);
+
+  // refined pattern
+  sortModel.setFilter("apr");
+
+  CHECK(sortModel.rowCount() == 1);
+
+  // changed and added rows
+  setCell(model, 2, 0, "aprils");
+
+  CHECK(sortModel.rowCount() == 2);
+
+  addRow(model, "apron");
+
+  CHECK(sortModel.rowCount() == 3);
+
+  // base class filter settings
+  sortModel.setFilter("APR");
+
+  CHECK(sortModel.rowCount() == 0);
+
+  sortModel.setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+  CHECK(sortModel.rowCount() == 3);
+
+  sortModel.setFilter("y");
+
+  CHECK(sortModel.rowCount() == 0);
+
+  sortModel.setFilterKeyColumn(1);
+
+  CHECK(sortModel.rowCount() == 2);
+
+  // any column
+  sortModel.setFilter("r");
+
+  CHECK(sortModel.rowCount() == 0);
+
+  sortModel.setFilterKeyColumn(-1);
+
+  CHECK(sortModel.rowCount() == 3);
+
+  // inherited filter
+  sortModel.setFilter("");
+  sortModel.setFilterWildcard("x");
+
+  CHECK(sortModel.rowCount() == 2);
+}
+
+//! block visitor saving typed values of visited blocks
+class TestBlockVisitor : public CQModelBlockVisitor {
+ public:
+  using ColumnValues = CQModelBlockVisitor::ColumnValues;
+
+  State visitBlock(const QAbstractItemModel *, const Block &block) override {
+    ++numBlocks;
+
+    for (size_t ic = 0; ic < block.columns.size(); ++ic) {
+      const auto &values = block.columns[ic];
+
+      if (ic >= columns.size())
+        columns.resize(ic + 1);
+
+      auto &columnValues = columns[ic];
+
+      for (int i = 0; i < block.numRows; ++i) {
+        auto i1 = size_t(i);
+
+        columnValues.valid.push_back(values.valid[i1]);
+
+        switch (values.type) {
+          case ValueType::REAL   : columnValues.reals   .push_back(values.reals   [i1]); break;
+          case ValueType::INTEGER: columnValues.integers.push_back(values.integers[i1]); break;
+          case ValueType::STRING : columnValues.strings .push_back(values.strings [i1]); break;
+          default                : columnValues.variants.push_back(values.variants[i1]); break;
+        }
+      }
+    }
+
+    return State::OK;
+  }
+
+  int                       numBlocks { 0 };
+  std::vector<ColumnValues> columns;
+};
+
+// block visit typed column values and valid flags
+void testBlockVisit() {
+  CQDataModel model(2, 0);
+
+  QVariantList values = {
+    QVariant(1), QVariant(2.0), QVariant(2.5), QVariant(QString("3")),
+    QVariant(QString("x")), QVariant() };
+
+  for (const auto &value : values)
+    addRow(model, value);
+
+  setCell(model, 0, 1, "a");
+
+  using ValueType = CQModelBlockVisitor::ValueType;
+
+  // raw (model cell) values
+  TestBlockVisitor visitor;
+
+  visitor.setBlockSize(4);
+
+  visitor.addColumn(0, ValueType::REAL);
+  visitor.addColumn(0, ValueType::INTEGER);
+  visitor.addColumn(1, ValueType::STRING);
+  visitor.addColumn(2, ValueType::REAL);
+
+  CHECK(CQModelVisit::execBlocks(&model, visitor));
+
+  CHECK(visitor.numBlocks == 2);
+
+  if (! CHECK(visitor.columns.size() == 4))
+    return;
+
+  const auto &reals    = visitor.columns[0];
+  const auto &integers = visitor.columns[1];
+  const auto &strings  = visitor.columns[2];
+  const auto &invalid  = visitor.columns[3];
+
+  CHECK(reals.valid == std::vector<unsigned char>({1, 1, 1, 1, 0, 0}));
+  CHECK(reals.reals.size() == 6 && reals.reals[2] == 2.5 && reals.reals[3] == 3.0);
+
+  // non-integral real is not a valid integer
+  CHECK(integers.valid == std::vector<unsigned char>({1, 1, 0, 1, 0, 0}));
+  CHECK(integers.integers.size() == 6 && integers.integers[1] == 2 &&
+        integers.integers[3] == 3);
+
+  CHECK(strings.valid == std::vector<unsigned char>({1, 0, 0, 0, 0, 0}));
+  CHECK(strings.strings.size() == 6 && strings.strings[0] == "a");
+
+  // invalid column
+  CHECK(invalid.valid == std::vector<unsigned char>(6, 0));
+}
+
+// column datas follow data column when columns are projected
+void testColumnMap() {
+  TestDataModel model(3, 0);
+
+  addRow(model, "a");
+
+  setCell(model, 0, 1, "1");
+  setCell(model, 0, 2, "x");
+
+  model.setColumnTitle(0, "A");
+  model.setColumnKey  (0, true);
+  model.setColumnType (1, CQBaseModelType::INTEGER);
+
+  CHECK(model.data(model.index(0, 1), Qt::EditRole) == QVariant(1));
+
+  model.setColumnMap(CQDataModel::Columns({2, 0}));
+
+  CHECK(model.columnCount() == 2);
+  CHECK(model.columnTitle(1) == "A");
+  CHECK(model.isColumnKey(1));
+  CHECK(! model.isColumnKey(0));
+  CHECK(model.columnType(0) != CQBaseModelType::INTEGER);
+  CHECK(model.rowForKey(1, "a") == 0);
+  CHECK(model.data(model.index(0, 0), Qt::EditRole).toString() == "x");
+
+  model.setColumnMap(CQDataModel::Columns());
+
+  CHECK(model.columnType(1) == CQBaseModelType::INTEGER);
+  CHECK(model.columnTitle(0) == "A");
+}
+
+// unique values of non-numeric, non-string typed column (stored as strings)
+void testColorColumnValues() {
+  CQDataModel model(1, 0);
+
+  addRow(model, "red");
+  addRow(model, "blue");
+  addRow(model, "red");
+
+  model.setColumnType(0, CQBaseModelType::COLOR);
+
+  CQModelDetails modelDetails(&model);
+
+  const auto *details = modelDetails.columnDetails(0);
+
+  CHECK(details->type() == CQBaseModelType::COLOR);
+  CHECK(details->numValues() == 2);
+  CHECK(details->valueInd("red" ) == 0);
+  CHECK(details->valueInd("blue") == 1);
+  CHECK(details->valueInd("green") == -1);
+  CHECK(details->uniqueValues().size() == 2);
+  CHECK(details->uniqueCounts() == CQModelColumnDetails::VariantList({2, 1}));
+}
+
+// pivot aggregates updated incrementally on source insert, update and remove
+void testPivotMedian() {
+  TestDataModel source(2, 0);
+
+  auto addSourceRow = [&](const QString &key, double value) {
+    addRow(source, key);
+
+    setCell(source, source.rowCount() - 1, 1, value);
+  };
+
+  addSourceRow("a", 3);
+  addSourceRow("a", 1);
+  addSourceRow("b", 5);
+
+  using AggregateType = CQPivotModel::AggregateType;
+
+  CQPivotModel::Aggregates aggregates;
+
+  aggregates.push_back(CQPivotModel::Aggregate(1, AggregateType::MEDIAN));
+  aggregates.push_back(CQPivotModel::Aggregate(1, AggregateType::MIN   ));
+  aggregates.push_back(CQPivotModel::Aggregate(1, AggregateType::MAX   ));
+
+  CQPivotModel pivot(&source, CQPivotModel::Columns({0}), aggregates);
+
+  auto pivotValue = [&](int row, int column) {
+    return pivot.data(pivot.index(row, column), Qt::EditRole).toDouble();
+  };
+
+  CHECK(pivot.rowCount() == 2);
+  CHECK(pivotValue(0, 1) == 2.0);
+  CHECK(pivotValue(1, 1) == 5.0);
+
+  // insert (odd count)
+  addSourceRow("a", 10);
+
+  CHECK(pivotValue(0, 1) == 3.0);
+  CHECK(pivotValue(0, 2) == 1.0);
+  CHECK(pivotValue(0, 3) == 10.0);
+
+  // insert (even count)
+  addSourceRow("a", 12);
+
+  CHECK(pivotValue(0, 1) == 6.5);
+
+  // insert (duplicate value)
+  addSourceRow("a", 3);
+
+  CHECK(pivotValue(0, 1) == 3.0);
+
+  // update value (a: 1, 3, 3, 10, 12 -> 0, 1, 3, 3, 10)
+  setCell(source, 4, 1, 0.0);
+
+  CHECK(pivotValue(0, 1) == 3.0);
+  CHECK(pivotValue(0, 2) == 0.0);
+  CHECK(pivotValue(0, 3) == 10.0);
+
+  // update key (moves value 10 to group b)
+  setCell(source, 3, 0, "b");
+
+  CHECK(pivotValue(0, 1) == 2.0);
+  CHECK(pivotValue(1, 1) == 7.5);
+
+  // remove rows (a: 0, 1, 3, 3 -> 0, 1, 3 -> 0, 3)
+  source.removeRow(0);
+
+  CHECK(pivotValue(0, 1) == 1.0);
+  CHECK(pivotValue(0, 3) == 3.0);
+
+  source.removeRow(0);
+
+  CHECK(pivotValue(0, 1) == 1.5);
+
+  // remove all rows of group
+  source.removeRow(2);
+  source.removeRow(2);
+
+  CHECK(pivot.rowCount() == 1);
+  CHECK(pivotValue(0, 1) == 7.5);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication app(argc, argv);
+
+  testKeyColumn();
+  testColumnIndex();
+  testSortFilter();
+  testBlockVisit();
+  testColumnMap();
+  testColorColumnValues();
+  testPivotMedian();
+
+  std::cerr << s_numChecks - s_numFailed << "/" << s_numChecks << " checks passed\n";
+
+  return s_numFailed;
+}
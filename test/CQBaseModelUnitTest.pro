@@ -0,0 +1,50 @@
+TEMPLATE = app
+
+TARGET = CQBaseModelUnitTest
+
+QT += widgets
+
+CONFIG += console
+
+DEPENDPATH += .
+
+QMAKE_CXXFLAGS += \
+-std=c++17 \
+
+MOC_DIR = .moc
+
+SOURCES += \
+CQBaseModelUnitTest.cpp \
+
+DESTDIR     = ../bin
+OBJECTS_DIR = ../obj
+
+INCLUDEPATH += \
+. \
+../include \
+../../CQUtil/include \
+../../CUtil/include \
+../../CFont/include \
+../../CMath/include \
+../../COS/include \
+
+PRE_TARGETDEPS = \
+../lib/libCQBaseModel.a \
+
+unix:LIBS += \
+-L../lib \
+-L../../CQUtil/lib \
+-L../../CFont/lib \
+-L../../CImageLib/lib \
+-L../../CConfig/lib \
+-L../../CUtil/lib \
+-L../../CFileUtil/lib \
+-L../../CFile/lib \
+-L../../CMath/lib \
+-L../../CStrUtil/lib \
+-L../../CRegExp/lib \
+-L../../COS/lib \
+-lCQBaseModel -lCQUtil \
+-lCFont -lCImageLib -lCConfig -lCUtil \
+-lCFileUtil -lCFile -lCMath -lCStrUtil -lCRegExp -lCOS \
+-lpng -ljpeg -ltre
@@ -7,7 +7,7 @@ QT += widgets
 DEPENDPATH += .
 
 QMAKE_CXXFLAGS += \
--std=c++14 \
+-std=c++17 \
 
 MOC_DIR = .moc
 